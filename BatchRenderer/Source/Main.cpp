@@ -0,0 +1,290 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Headless batch renderer: runs ParametricEQ2AudioProcessor over a directory
+    of audio files without an editor or a host.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+struct RenderSettings
+{
+	juce::File inputDirectory;
+	juce::File outputDirectory;
+	juce::MemoryBlock state;
+	juce::StringPairArray parameterValues;
+	juce::File stateToSave;
+	int numThreads = juce::SystemStats::getNumCpus();
+	int blockSize = 65536;
+	bool recursive = false;
+};
+
+static void printUsage()
+{
+	std::cout << "Usage: ParametricEQ2BatchRenderer --input <dir> --output <dir> [options]\n"
+		"  --state <file>        restore a saved plugin state (getStateInformation format)\n"
+		"  --set <id>=<value>    set a parameter in its own units, e.g. --set band2_gain=-3\n"
+		"  --save-state <file>   write the resulting state so it can be reused with --state\n"
+		"  --threads <n>         number of files rendered in parallel (default: all cores)\n"
+		"  --block <n>           samples read, processed and written per step (default: 65536)\n"
+		"  --recursive           also render files in sub directories\n";
+}
+
+static bool parseArguments(const juce::StringArray& args, RenderSettings& settings)
+{
+	for (int i = 0; i < args.size(); ++i)
+	{
+		const auto& arg = args[i];
+		auto next = [&args, &i]() { return ++i < args.size() ? args[i] : juce::String(); };
+
+		if (arg == "--input")
+			settings.inputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(next());
+		else if (arg == "--output")
+			settings.outputDirectory = juce::File::getCurrentWorkingDirectory().getChildFile(next());
+		else if (arg == "--state")
+		{
+			auto stateFile = juce::File::getCurrentWorkingDirectory().getChildFile(next());
+			if (!stateFile.loadFileAsData(settings.state))
+			{
+				std::cerr << "Could not read state file " << stateFile.getFullPathName() << "\n";
+				return false;
+			}
+		}
+		else if (arg == "--set")
+		{
+			auto assignment = next();
+			settings.parameterValues.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+				assignment.fromFirstOccurrenceOf("=", false, false).trim());
+		}
+		else if (arg == "--save-state")
+			settings.stateToSave = juce::File::getCurrentWorkingDirectory().getChildFile(next());
+		else if (arg == "--threads")
+			settings.numThreads = juce::jmax(1, next().getIntValue());
+		else if (arg == "--block")
+			settings.blockSize = juce::jmax(64, next().getIntValue());
+		else if (arg == "--recursive")
+			settings.recursive = true;
+		else
+		{
+			std::cerr << "Unknown argument " << arg << "\n";
+			return false;
+		}
+	}
+
+	return settings.inputDirectory.isDirectory() && settings.outputDirectory != juce::File();
+}
+
+static bool applySettings(ParametricEQ2AudioProcessor& processor, const RenderSettings& settings)
+{
+	if (settings.state.getSize() > 0)
+		processor.setStateInformation(settings.state.getData(), (int)settings.state.getSize());
+
+	for (auto& id : settings.parameterValues.getAllKeys())
+	{
+		auto* param = processor.apvts.getParameter(id);
+		if (param == nullptr)
+		{
+			std::cerr << "Unknown parameter " << id << "\n";
+			return false;
+		}
+
+		auto value = settings.parameterValues[id].getFloatValue();
+		param->setValueNotifyingHost(param->convertTo0to1(value));
+	}
+
+	return true;
+}
+
+static bool setChannelLayout(ParametricEQ2AudioProcessor& processor, int numChannels)
+{
+	auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+	if (channelSet.isDisabled())
+		channelSet = juce::AudioChannelSet::discreteChannels(numChannels);
+
+	juce::AudioProcessor::BusesLayout layout;
+	layout.inputBuses.add(channelSet);
+	//dynamic bands fall back to the main input without a sidechain
+	layout.inputBuses.add(juce::AudioChannelSet::disabled());
+	layout.outputBuses.add(channelSet);
+
+	return processor.setBusesLayout(layout);
+}
+
+static juce::String renderFile(const juce::File& input, const juce::File& output, const RenderSettings& settings)
+{
+	juce::AudioFormatManager formatManager;
+	formatManager.registerBasicFormats();
+
+	std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(input));
+	if (reader == nullptr)
+		return "unreadable";
+
+	const auto numChannels = (int)reader->numChannels;
+	const auto sampleRate = reader->sampleRate;
+	const auto blockSize = settings.blockSize;
+
+	ParametricEQ2AudioProcessor processor;
+
+	if (!setChannelLayout(processor, numChannels))
+		return "unsupported channel count";
+
+	if (!applySettings(processor, settings))
+		return "bad settings";
+
+	processor.setNonRealtime(true);
+	processor.prepareToPlay(sampleRate, blockSize);
+
+	juce::AudioBuffer<float> buffer(numChannels, blockSize);
+	juce::MidiBuffer midi;
+
+	//give background work such as the linear phase kernel a chance to land, then run silence
+	//for a little longer so any crossfade into it has finished before the first real sample
+	bool ready = false;
+
+	for (int attempt = 0; attempt < 200 && !ready; ++attempt)
+	{
+		buffer.clear();
+		processor.processBlock(buffer, midi);
+
+		ready = processor.isReadyToRender();
+		if (!ready)
+			juce::Thread::sleep(5);
+	}
+
+	//rendering anyway would write the file through a stale kernel, or none at all
+	if (!ready)
+		return "linear phase kernel did not load";
+
+	for (int preRoll = 0; preRoll < juce::roundToInt(sampleRate * 0.2); preRoll += blockSize)
+	{
+		buffer.clear();
+		processor.processBlock(buffer, midi);
+	}
+
+	auto* format = formatManager.findFormatForFileExtension(output.getFileExtension());
+	if (format == nullptr)
+		return "no writer for " + output.getFileExtension();
+
+	output.deleteFile();
+	auto stream = output.createOutputStream();
+	if (stream == nullptr)
+		return "could not open output";
+
+	auto bitsPerSample = format->getPossibleBitDepths().contains((int)reader->bitsPerSample)
+		? (int)reader->bitsPerSample
+		: format->getPossibleBitDepths().getLast();
+
+	std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(),
+		sampleRate,
+		(unsigned int)numChannels,
+		bitsPerSample,
+		reader->metadataValues,
+		0));
+
+	if (writer == nullptr)
+		return "could not create writer";
+
+	stream.release(); //owned by the writer now
+
+	//the first latency samples are the filter's delay, the file is extended by the same amount to flush it
+	auto samplesToSkip = (juce::int64)processor.getLatencySamples();
+	const auto totalInputSamples = reader->lengthInSamples;
+	const auto totalSamples = totalInputSamples + samplesToSkip;
+
+	for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+	{
+		auto numSamples = (int)juce::jmin((juce::int64)blockSize, totalSamples - position);
+
+		buffer.clear();
+		if (position < totalInputSamples)
+			reader->read(&buffer, 0, (int)juce::jmin((juce::int64)numSamples, totalInputSamples - position), position, true, true);
+
+		buffer.setSize(numChannels, numSamples, true, false, true);
+		processor.processBlock(buffer, midi);
+
+		auto skip = (int)juce::jmin((juce::int64)numSamples, samplesToSkip);
+		samplesToSkip -= skip;
+
+		if (numSamples > skip && !writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip))
+			return "write failed";
+
+		buffer.setSize(numChannels, blockSize, false, false, true);
+	}
+
+	processor.releaseResources();
+	return {};
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	juce::StringArray args;
+	for (int i = 1; i < argc; ++i)
+		args.add(juce::CharPointer_UTF8(argv[i]));
+
+	RenderSettings settings;
+	if (!parseArguments(args, settings))
+	{
+		printUsage();
+		return 1;
+	}
+
+	if (settings.stateToSave != juce::File())
+	{
+		ParametricEQ2AudioProcessor processor;
+		if (!applySettings(processor, settings))
+			return 1;
+
+		juce::MemoryBlock state;
+		processor.getStateInformation(state);
+		settings.stateToSave.replaceWithData(state.getData(), state.getSize());
+	}
+
+	auto files = settings.inputDirectory.findChildFiles(juce::File::findFiles, settings.recursive, "*.wav;*.flac");
+	if (files.isEmpty())
+	{
+		std::cerr << "No .wav or .flac files in " << settings.inputDirectory.getFullPathName() << "\n";
+		return 1;
+	}
+
+	settings.outputDirectory.createDirectory();
+
+	juce::ThreadPool pool(settings.numThreads);
+	std::atomic<int> numFailed{ 0 };
+	juce::CriticalSection logLock;
+
+	for (auto& file : files)
+	{
+		auto output = settings.outputDirectory.getChildFile(file.getRelativePathFrom(settings.inputDirectory));
+		output.getParentDirectory().createDirectory();
+
+		pool.addJob([file, output, &settings, &numFailed, &logLock]
+			{
+				auto startTime = juce::Time::getMillisecondCounterHiRes();
+				auto error = renderFile(file, output, settings);
+				auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+				const juce::ScopedLock sl(logLock);
+				if (error.isEmpty())
+				{
+					std::cout << file.getFileName() << " -> " << output.getFullPathName() << " (" << seconds << " s)\n";
+				}
+				else
+				{
+					std::cerr << file.getFileName() << ": " << error << "\n";
+					++numFailed;
+				}
+			});
+	}
+
+	while (pool.getNumJobs() > 0)
+		juce::Thread::sleep(50);
+
+	return numFailed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,479 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    processBlock micro benchmarks. Every case prints one JSON object per line
+    (or one CSV row with --csv) so results from two builds can be diffed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#if JUCE_INTEL && JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+static juce::uint64 readCycleCounter()
+{
+#if JUCE_INTEL && JUCE_MSVC
+	return __rdtsc();
+#elif JUCE_INTEL
+	return __builtin_ia32_rdtsc();
+#else
+	return 0;
+#endif
+}
+
+#if JUCE_INTEL
+static constexpr bool hasCycleCounter = true;
+#else
+static constexpr bool hasCycleCounter = false;
+#endif
+
+struct BenchmarkCase
+{
+	juce::String target;
+	juce::String filterMode;
+	BandType type;
+	Slope slope;
+	int blockSize;
+	double sampleRate;
+	bool automated;
+};
+
+struct BenchmarkResult
+{
+	double nsPerSample = 0.0;
+	double cyclesPerSample = 0.0;
+	double worstBlockNs = 0.0;
+};
+
+struct BenchmarkOptions
+{
+	double secondsPerCase = 0.5;
+	bool csv = false;
+	bool quick = false;
+	juce::StringArray filterModes{ "biquad" };
+	juce::StringArray targets{ "processor", "monochain" };
+};
+
+static juce::String getTypeName(BandType type)
+{
+	switch (type)
+	{
+	case BandType::LowPass: return "LowPass";
+	case BandType::Peak: return "Peak";
+	case BandType::HighPass: return "HighPass";
+	}
+
+	return {};
+}
+
+static int getFilterModeIndex(const juce::String& name)
+{
+	if (name == "svf") return FilterMode::SmoothSvf;
+	if (name == "linear") return FilterMode::LinearPhase;
+	return FilterMode::Biquad;
+}
+
+//All three bands get the type under test, spread over the spectrum, so a case measures the full cascade
+static ChainSettings makeChainSettings(BandType type, Slope slope)
+{
+	ChainSettings settings;
+	const float freqs[] = { 100.f, 1000.f, 8000.f };
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		settings.bandSettings[i].band_freq = freqs[i % 3];
+		settings.bandSettings[i].band_gain = 6.f;
+		settings.bandSettings[i].band_type = type;
+		settings.bandSettings[i].band_slope = slope;
+	}
+
+	return settings;
+}
+
+static void setParameter(ParametricEQ2AudioProcessor& processor, const juce::String& id, float value)
+{
+	if (auto* param = processor.apvts.getParameter(id))
+		param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+static float getAutomatedFreq(int blockIndex, float baseFreq)
+{
+	//slow sweep of +-1 octave so every block sees a different frequency
+	return baseFreq * std::pow(2.f, std::sin((float)blockIndex * 0.05f));
+}
+
+static void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random)
+{
+	for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+	{
+		auto* data = buffer.getWritePointer(ch);
+		for (int i = 0; i < buffer.getNumSamples(); ++i)
+			data[i] = random.nextFloat() * 0.5f - 0.25f;
+	}
+}
+
+template<typename ProcessFunction>
+static BenchmarkResult measure(const BenchmarkCase& benchmarkCase, const BenchmarkOptions& options, ProcessFunction&& process)
+{
+	juce::AudioBuffer<float> source(2, benchmarkCase.blockSize), buffer(2, benchmarkCase.blockSize);
+	juce::Random random(1234);
+	fillWithNoise(source, random);
+
+	const auto totalBlocks = juce::jmax(8, (int)(options.secondsPerCase * benchmarkCase.sampleRate / benchmarkCase.blockSize));
+	const auto warmupBlocks = juce::jmax(4, totalBlocks / 10);
+	const auto ticksPerSecond = (double)juce::Time::getHighResolutionTicksPerSecond();
+
+	BenchmarkResult result;
+	juce::int64 totalTicks = 0;
+	juce::uint64 totalCycles = 0;
+
+	for (int block = 0; block < warmupBlocks + totalBlocks; ++block)
+	{
+		buffer.makeCopyOf(source, true);
+
+		auto startCycles = readCycleCounter();
+		auto startTicks = juce::Time::getHighResolutionTicks();
+
+		process(buffer, block);
+
+		auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+		auto cycles = readCycleCounter() - startCycles;
+
+		if (block < warmupBlocks)
+			continue;
+
+		totalTicks += ticks;
+		totalCycles += cycles;
+		result.worstBlockNs = juce::jmax(result.worstBlockNs, ticks * 1.0e9 / ticksPerSecond);
+	}
+
+	const auto totalSamples = (double)totalBlocks * benchmarkCase.blockSize;
+	result.nsPerSample = totalTicks * 1.0e9 / ticksPerSecond / totalSamples;
+	result.cyclesPerSample = (double)totalCycles / totalSamples;
+
+	return result;
+}
+
+static BenchmarkResult runProcessorCase(const BenchmarkCase& benchmarkCase, const BenchmarkOptions& options)
+{
+	ParametricEQ2AudioProcessor processor;
+	auto chainSettings = makeChainSettings(benchmarkCase.type, benchmarkCase.slope);
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		const auto& band = chainSettings.bandSettings[i];
+		setParameter(processor, getParameterId(i + 1, "freq"), band.band_freq);
+		setParameter(processor, getParameterId(i + 1, "gain"), band.band_gain);
+		setParameter(processor, getParameterId(i + 1, "type"), (float)band.band_type);
+		setParameter(processor, getParameterId(i + 1, "slope"), (float)band.band_slope);
+	}
+
+	setParameter(processor, "filter_mode", (float)getFilterModeIndex(benchmarkCase.filterMode));
+
+	processor.prepareToPlay(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+
+	juce::MidiBuffer midi;
+	juce::AudioBuffer<float> silence(2, benchmarkCase.blockSize);
+
+	for (int attempt = 0; attempt < 200; ++attempt)
+	{
+		silence.clear();
+		processor.processBlock(silence, midi);
+
+		if (processor.isReadyToRender())
+			break;
+
+		juce::Thread::sleep(5);
+	}
+
+	//parameter IDs are built up front so the measured loop only sees the processor's own cost
+	juce::StringArray freqIds;
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+		freqIds.add(getParameterId(i + 1, "freq"));
+
+	auto result = measure(benchmarkCase, options, [&](juce::AudioBuffer<float>& buffer, int block)
+		{
+			if (benchmarkCase.automated)
+			{
+				for (int i = 0; i < ChainSettings::numBands; ++i)
+					setParameter(processor, freqIds[i], getAutomatedFreq(block, chainSettings.bandSettings[i].band_freq));
+			}
+
+			processor.processBlock(buffer, midi);
+		});
+
+	processor.releaseResources();
+	return result;
+}
+
+//==============================================================================
+//The per band juce::dsp::ProcessorChain the processor ran before its engines, one chain per channel
+
+using Filter = juce::dsp::IIR::Filter<float>;
+
+using BandFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
+
+template<size_t>
+using BandFilterSlot = BandFilter;
+
+template<typename Indices>
+struct MonoChainForBands;
+
+template<size_t... Indices>
+struct MonoChainForBands<std::index_sequence<Indices...>>
+{
+	using Type = juce::dsp::ProcessorChain<BandFilterSlot<Indices>...>;
+};
+
+//One BandFilter per compiled band
+using MonoChain = MonoChainForBands<BandIndices>::Type;
+
+using Coefficients = Filter::CoefficientsPtr;
+
+static void updateCoefficients(Coefficients& old, const Coefficients& replacement)
+{
+	*old = *replacement;
+}
+
+template<typename BandType, typename CoefficientsType>
+void updatePeakFilter(BandType& band, CoefficientsType& coefficients)
+{
+	band.template setBypassed<1>(true);
+	band.template setBypassed<2>(true);
+	band.template setBypassed<3>(true);
+
+	updateCoefficients(band.template get<0>().coefficients, coefficients);
+}
+
+template<typename BandType, typename CoefficientsType>
+void updateLowHighPassFilter(BandType& band, CoefficientsType& coefficients, Slope& slope) {
+	band.template setBypassed<0>(true);
+	band.template setBypassed<1>(true);
+	band.template setBypassed<2>(true);
+	band.template setBypassed<3>(true);
+
+	switch (slope)
+	{
+	case Slope_48:
+	{
+		updateCoefficients(band.template get<3>().coefficients, coefficients[3]);
+		band.template setBypassed<3>(false);
+	}
+	case Slope_36:
+	{
+		updateCoefficients(band.template get<2>().coefficients, coefficients[2]);
+		band.template setBypassed<2>(false);
+	}
+	case Slope_24:
+	{
+		updateCoefficients(band.template get<1>().coefficients, coefficients[1]);
+		band.template setBypassed<1>(false);
+	}
+	case Slope_12:
+	{
+		updateCoefficients(band.template get<0>().coefficients, coefficients[0]);
+		band.template setBypassed<0>(false);
+	}
+	}
+}
+
+//Designs the band once and copies the coefficients into every chain passed in
+template<int Index, typename... ChainTypes>
+void updateBand(const ChainSettings& chainSettings, double sampleRate, ChainTypes&... chains)
+{
+	auto bandSettings = chainSettings.bandSettings[Index];
+
+	switch (bandSettings.band_type)
+	{
+	case BandType::LowPass:
+	{
+		auto lowpass_coefficients = makeLowPassFilter(bandSettings, sampleRate);
+
+		(updateLowHighPassFilter(chains.template get<Index>(), lowpass_coefficients, bandSettings.band_slope), ...);
+		break;
+	}
+	case BandType::Peak:
+	{
+		auto peak_coefficients = makePeakFilter(bandSettings, sampleRate);
+
+		(updatePeakFilter(chains.template get<Index>(), peak_coefficients), ...);
+		break;
+	}
+	case BandType::HighPass:
+	{
+		auto highpass_coefficients = makeHighPassFilter(bandSettings, sampleRate);
+
+		(updateLowHighPassFilter(chains.template get<Index>(), highpass_coefficients, bandSettings.band_slope), ...);
+		break;
+	}
+	}
+}
+
+template<typename... ChainTypes, size_t... Indices>
+void updateAllBands(const ChainSettings& chainSettings, double sampleRate, std::index_sequence<Indices...>, ChainTypes&... chains)
+{
+	(updateBand<(int)Indices>(chainSettings, sampleRate, chains...), ...);
+}
+
+template<typename... ChainTypes>
+void updateAllBands(const ChainSettings& chainSettings, double sampleRate, ChainTypes&... chains)
+{
+	updateAllBands(chainSettings, sampleRate, BandIndices(), chains...);
+}
+
+static void updateMonoChains(const ChainSettings& chainSettings, double sampleRate, MonoChain& left, MonoChain& right)
+{
+	updateAllBands(chainSettings, sampleRate, left, right);
+}
+
+//The pre-engine baseline kept for comparison: the scalar per band juce::dsp::ProcessorChain
+static BenchmarkResult runMonoChainCase(const BenchmarkCase& benchmarkCase, const BenchmarkOptions& options)
+{
+	MonoChain left, right;
+
+	juce::dsp::ProcessSpec spec;
+	spec.sampleRate = benchmarkCase.sampleRate;
+	spec.maximumBlockSize = (juce::uint32)benchmarkCase.blockSize;
+	spec.numChannels = 1;
+
+	left.prepare(spec);
+	right.prepare(spec);
+
+	auto chainSettings = makeChainSettings(benchmarkCase.type, benchmarkCase.slope);
+	updateMonoChains(chainSettings, benchmarkCase.sampleRate, left, right);
+
+	return measure(benchmarkCase, options, [&](juce::AudioBuffer<float>& buffer, int block)
+		{
+			if (benchmarkCase.automated)
+			{
+				auto automatedSettings = chainSettings;
+				for (auto& band : automatedSettings.bandSettings)
+					band.band_freq = getAutomatedFreq(block, band.band_freq);
+
+				updateMonoChains(automatedSettings, benchmarkCase.sampleRate, left, right);
+			}
+
+			juce::dsp::AudioBlock<float> audioBlock(buffer);
+			auto leftBlock = audioBlock.getSingleChannelBlock(0);
+			auto rightBlock = audioBlock.getSingleChannelBlock(1);
+
+			left.process(juce::dsp::ProcessContextReplacing<float>(leftBlock));
+			right.process(juce::dsp::ProcessContextReplacing<float>(rightBlock));
+		});
+}
+
+static void printResult(const BenchmarkCase& c, const BenchmarkResult& r, const BenchmarkOptions& options)
+{
+	if (options.csv)
+	{
+		std::cout << c.target << "," << c.filterMode << "," << getTypeName(c.type) << "," << (12 + 12 * (int)c.slope) << ","
+			<< c.blockSize << "," << c.sampleRate << "," << (c.automated ? "automated" : "static") << ","
+			<< r.nsPerSample << "," << (hasCycleCounter ? juce::String(r.cyclesPerSample) : juce::String()) << ","
+			<< r.worstBlockNs << "\n";
+		return;
+	}
+
+	auto* object = new juce::DynamicObject();
+	object->setProperty("target", c.target);
+	object->setProperty("filterMode", c.filterMode);
+	object->setProperty("type", getTypeName(c.type));
+	object->setProperty("slopeDbPerOct", 12 + 12 * (int)c.slope);
+	object->setProperty("blockSize", c.blockSize);
+	object->setProperty("sampleRate", c.sampleRate);
+	object->setProperty("parameters", c.automated ? "automated" : "static");
+	object->setProperty("nsPerSample", r.nsPerSample);
+	object->setProperty("cyclesPerSample", hasCycleCounter ? juce::var(r.cyclesPerSample) : juce::var());
+	object->setProperty("worstBlockNs", r.worstBlockNs);
+
+	std::cout << juce::JSON::toString(juce::var(object), true) << "\n";
+}
+
+static bool parseArguments(const juce::StringArray& args, BenchmarkOptions& options)
+{
+	for (int i = 0; i < args.size(); ++i)
+	{
+		const auto& arg = args[i];
+		auto next = [&args, &i]() { return ++i < args.size() ? args[i] : juce::String(); };
+
+		if (arg == "--seconds")
+			options.secondsPerCase = juce::jmax(0.01, next().getDoubleValue());
+		else if (arg == "--csv")
+			options.csv = true;
+		else if (arg == "--quick")
+			options.quick = true;
+		else if (arg == "--modes")
+			options.filterModes = juce::StringArray::fromTokens(next(), ",", {});
+		else if (arg == "--targets")
+			options.targets = juce::StringArray::fromTokens(next(), ",", {});
+		else
+		{
+			std::cerr << "Usage: ParametricEQ2Benchmarks [--seconds <s>] [--csv] [--quick]\n"
+				"       [--modes biquad,svf,linear] [--targets processor,monochain]\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	juce::StringArray args;
+	for (int i = 1; i < argc; ++i)
+		args.add(juce::CharPointer_UTF8(argv[i]));
+
+	BenchmarkOptions options;
+	if (!parseArguments(args, options))
+		return 1;
+
+	std::vector<int> blockSizes;
+	std::vector<double> sampleRates;
+
+	if (options.quick)
+	{
+		blockSizes = { 32, 512, 4096 };
+		sampleRates = { 48000.0, 96000.0 };
+	}
+	else
+	{
+		for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+			blockSizes.push_back(blockSize);
+
+		sampleRates = { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+	}
+
+	if (options.csv)
+		std::cout << "target,filterMode,type,slopeDbPerOct,blockSize,sampleRate,parameters,nsPerSample,cyclesPerSample,worstBlockNs\n";
+
+	for (auto& target : options.targets)
+	{
+		//the monochain baseline only knows the biquad path
+		auto filterModes = target == "monochain" ? juce::StringArray{ "biquad" } : options.filterModes;
+
+		for (auto& filterMode : filterModes)
+			for (auto type : { BandType::LowPass, BandType::Peak, BandType::HighPass })
+				for (auto slope : { Slope::Slope_12, Slope::Slope_24, Slope::Slope_36, Slope::Slope_48 })
+					for (auto sampleRate : sampleRates)
+						for (auto blockSize : blockSizes)
+							for (auto automated : { false, true })
+							{
+								BenchmarkCase benchmarkCase{ target, filterMode, type, slope, blockSize, sampleRate, automated };
+
+								auto result = target == "monochain"
+									? runMonoChainCase(benchmarkCase, options)
+									: runProcessorCase(benchmarkCase, options);
+
+								printResult(benchmarkCase, result, options);
+							}
+	}
+
+	return 0;
+}
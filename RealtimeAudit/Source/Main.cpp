@@ -0,0 +1,310 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Realtime safety audit: drives ParametricEQ2AudioProcessor through every
+    parameter in every filter mode and oversampling setting, with allocation,
+    lock and syscall interception enabled around processBlock. Prints one JSON
+    object per distinct call stack and exits non zero if anything was caught.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <optional>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/RealtimeAudit.h"
+
+#if ! PARAMETRICEQ2_RT_AUDIT
+ #error "The realtime audit needs PARAMETRICEQ2_RT_AUDIT=1 in the project defines"
+#endif
+
+struct AuditOptions
+{
+	std::vector<double> sampleRates{ 44100.0, 96000.0 };
+	std::vector<int> blockSizes{ 64, 512 };
+	int blocksPerStep = 16;
+	//off by default: setValueNotifyingHost goes through JUCE's parameter listener locks, and on the
+	//message thread the designer's notify, neither of which the processor controls
+	bool auditAutomation = false;
+};
+
+//Where the audit was when a violation was first seen
+struct AuditContext
+{
+	double sampleRate = 0.0;
+	int blockSize = 0;
+	juce::String filterMode;
+	juce::String oversampling;
+	juce::String parameter;
+	juce::String value;
+	juce::String phase;
+};
+
+struct Finding
+{
+	RealtimeAudit::ViolationKind kind;
+	juce::String function;
+	juce::StringArray stack;
+	AuditContext firstSeen;
+	int count = 0;
+};
+
+class Auditor
+{
+public:
+	Auditor(const AuditOptions& auditOptions) : options(auditOptions) {}
+
+	void run(double sampleRate, int blockSize)
+	{
+		ParametricEQ2AudioProcessor processor;
+		processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+		processor.prepareToPlay(sampleRate, blockSize);
+
+		buffer.setSize(2, blockSize);
+		context = {};
+		context.sampleRate = sampleRate;
+		context.blockSize = blockSize;
+
+		auto* filterMode = processor.apvts.getParameter("filter_mode");
+		auto* oversampling = processor.apvts.getParameter("oversampling");
+
+		for (int mode = 0; mode < getNumValues(*filterMode); ++mode)
+		{
+			for (int order = 0; order < getNumValues(*oversampling); ++order)
+			{
+				//switching modes rebuilds kernels and latency, which is the host's business, not the audit's
+				RealtimeAudit::setEnabled(false);
+				filterMode->setValueNotifyingHost(getNormalisedValue(*filterMode, mode));
+				oversampling->setValueNotifyingHost(getNormalisedValue(*oversampling, order));
+				settle(processor);
+				RealtimeAudit::setEnabled(true);
+
+				context.filterMode = filterMode->getCurrentValueAsText();
+				context.oversampling = oversampling->getCurrentValueAsText();
+
+				for (auto* param : processor.getParameters())
+				{
+					if (param == filterMode || param == oversampling)
+						continue;
+
+					sweepParameter(processor, *param);
+				}
+			}
+		}
+
+		RealtimeAudit::setEnabled(false);
+		processor.releaseResources();
+	}
+
+	const std::vector<Finding>& getFindings() const { return findings; }
+	int getNumDropped() const { return numDropped; }
+
+private:
+	static int getNumValues(const juce::AudioProcessorParameter& param)
+	{
+		//discrete parameters get every step, continuous ones both ends, the middle and two points in between
+		return param.isDiscrete() ? juce::jmin(param.getNumSteps(), 16) : 5;
+	}
+
+	static float getNormalisedValue(const juce::AudioProcessorParameter& param, int index)
+	{
+		return (float)index / (float)juce::jmax(1, getNumValues(param) - 1);
+	}
+
+	void sweepParameter(ParametricEQ2AudioProcessor& processor, juce::AudioProcessorParameter& param)
+	{
+		const auto original = param.getValue();
+		context.parameter = param.getName(64);
+
+		for (int i = 0; i < getNumValues(param); ++i)
+		{
+			{
+				//hosts can deliver automation on the audio thread, --audit-automation audits that path too
+				std::optional<RealtimeAudit::ScopedAudioThread> automationScope;
+				if (options.auditAutomation)
+					automationScope.emplace();
+
+				param.setValueNotifyingHost(getNormalisedValue(param, i));
+			}
+
+			context.value = param.getCurrentValueAsText();
+			context.phase = "automation";
+			collect();
+
+			context.phase = "process";
+			processBlocks(processor, options.blocksPerStep);
+			collect();
+		}
+
+		param.setValueNotifyingHost(original);
+		processBlocks(processor, options.blocksPerStep);
+		collect();
+	}
+
+	void processBlocks(ParametricEQ2AudioProcessor& processor, int numBlocks)
+	{
+		juce::MidiBuffer midi;
+
+		for (int block = 0; block < numBlocks; ++block)
+		{
+			fillWithNoise();
+			processor.processBlock(buffer, midi);
+
+			//lets the designer thread publish, the way real time passes between host callbacks
+			juce::Thread::sleep(1);
+		}
+	}
+
+	void settle(ParametricEQ2AudioProcessor& processor)
+	{
+		for (int attempt = 0; attempt < 400; ++attempt)
+		{
+			processBlocks(processor, 1);
+
+			if (processor.isReadyToRender())
+				break;
+		}
+
+		processBlocks(processor, options.blocksPerStep);
+		RealtimeAudit::clear();
+	}
+
+	void fillWithNoise()
+	{
+		for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+		{
+			auto* data = buffer.getWritePointer(ch);
+			for (int i = 0; i < buffer.getNumSamples(); ++i)
+				data[i] = random.nextFloat() * 0.5f - 0.25f;
+		}
+	}
+
+	//Called between blocks only, so the log is never read while the audio thread writes it
+	void collect()
+	{
+		for (int i = 0; i < RealtimeAudit::getNumViolations(); ++i)
+		{
+			const auto& violation = RealtimeAudit::getViolation(i);
+			auto stack = RealtimeAudit::getSymbolisedStack(violation);
+
+			auto existing = std::find_if(findings.begin(), findings.end(), [&](const Finding& f)
+				{
+					return f.kind == violation.kind && f.stack == stack;
+				});
+
+			if (existing == findings.end())
+			{
+				findings.push_back({ violation.kind, violation.function, stack, context, 0 });
+				existing = findings.end() - 1;
+			}
+
+			++existing->count;
+		}
+
+		numDropped += RealtimeAudit::getNumDropped();
+		RealtimeAudit::clear();
+	}
+
+	const AuditOptions& options;
+	juce::AudioBuffer<float> buffer;
+	juce::Random random{ 1234 };
+	AuditContext context;
+	std::vector<Finding> findings;
+	int numDropped = 0;
+};
+
+static void printFinding(const Finding& finding)
+{
+	auto* object = new juce::DynamicObject();
+	object->setProperty("kind", RealtimeAudit::getKindName(finding.kind));
+	object->setProperty("function", finding.function);
+	object->setProperty("count", finding.count);
+	object->setProperty("sampleRate", finding.firstSeen.sampleRate);
+	object->setProperty("blockSize", finding.firstSeen.blockSize);
+	object->setProperty("filterMode", finding.firstSeen.filterMode);
+	object->setProperty("oversampling", finding.firstSeen.oversampling);
+	object->setProperty("parameter", finding.firstSeen.parameter);
+	object->setProperty("value", finding.firstSeen.value);
+	object->setProperty("phase", finding.firstSeen.phase);
+
+	juce::Array<juce::var> stack;
+	for (auto& frame : finding.stack)
+		stack.add(frame);
+
+	object->setProperty("stack", stack);
+
+	std::cout << juce::JSON::toString(juce::var(object), true) << "\n";
+}
+
+static std::vector<double> parseDoubles(const juce::String& text)
+{
+	std::vector<double> values;
+	for (auto& token : juce::StringArray::fromTokens(text, ",", {}))
+		values.push_back(token.getDoubleValue());
+	return values;
+}
+
+static std::vector<int> parseInts(const juce::String& text)
+{
+	std::vector<int> values;
+	for (auto& token : juce::StringArray::fromTokens(text, ",", {}))
+		values.push_back(juce::jmax(1, token.getIntValue()));
+	return values;
+}
+
+static bool parseArguments(const juce::StringArray& args, AuditOptions& options)
+{
+	for (int i = 0; i < args.size(); ++i)
+	{
+		const auto& arg = args[i];
+		auto next = [&args, &i]() { return ++i < args.size() ? args[i] : juce::String(); };
+
+		if (arg == "--rates")
+			options.sampleRates = parseDoubles(next());
+		else if (arg == "--blocks")
+			options.blockSizes = parseInts(next());
+		else if (arg == "--blocks-per-step")
+			options.blocksPerStep = juce::jmax(1, next().getIntValue());
+		else if (arg == "--audit-automation")
+			options.auditAutomation = true;
+		else
+		{
+			std::cerr << "Usage: ParametricEQ2RealtimeAudit [--rates 44100,96000] [--blocks 64,512]\n"
+				"       [--blocks-per-step <n>] [--audit-automation]\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	juce::StringArray args;
+	for (int i = 1; i < argc; ++i)
+		args.add(juce::CharPointer_UTF8(argv[i]));
+
+	AuditOptions options;
+	if (!parseArguments(args, options))
+		return 1;
+
+	Auditor auditor(options);
+
+	for (auto sampleRate : options.sampleRates)
+		for (auto blockSize : options.blockSizes)
+			auditor.run(sampleRate, blockSize);
+
+	for (auto& finding : auditor.getFindings())
+		printFinding(finding);
+
+	std::cerr << auditor.getFindings().size() << " distinct realtime violations";
+	if (auditor.getNumDropped() > 0)
+		std::cerr << ", " << auditor.getNumDropped() << " more not logged (log full)";
+	std::cerr << "\n";
+
+	return auditor.getFindings().empty() ? 0 : 2;
+}
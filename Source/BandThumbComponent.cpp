@@ -62,8 +62,8 @@ void BandThumbComponent::mouseDrag(const juce::MouseEvent& event)
 
     dragger.dragComponent(this, event, &constrainer);
 
-    auto freqParam = audioProcessor.apvts.getParameter(getParameterId(bandIndex + 1, "freq"));
-    auto gainParam = audioProcessor.apvts.getParameter(getParameterId(bandIndex + 1, "gain"));
+    auto freqParam = audioProcessor.parameters.getBand(bandIndex).freq.parameter;
+    auto gainParam = audioProcessor.parameters.getBand(bandIndex).gain.parameter;
 
     auto parentBounds = getParentComponent()->getLocalBounds();
     auto parentWidth = parentBounds.getWidth();
@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    BinaryState.cpp
+
+  ==============================================================================
+*/
+
+#include "BinaryState.h"
+
+namespace BinaryState
+{
+	static constexpr int headerSize = 3 * (int)sizeof(juce::uint32);
+	static constexpr int entrySize = (int)sizeof(juce::uint32) + (int)sizeof(float);
+
+	//the tree type APVTS stores each parameter's value under; everything else is carried as is
+	static const juce::Identifier parameterType{ "PARAM" };
+
+	juce::uint32 hashParameterId(const juce::String& parameterId)
+	{
+		juce::uint32 hash = 2166136261u;
+
+		for (auto* c = parameterId.toRawUTF8(); *c != 0; ++c)
+		{
+			hash ^= (juce::uint8)*c;
+			hash *= 16777619u;
+		}
+
+		return hash;
+	}
+
+	static void setIfChanged(juce::RangedAudioParameter& parameter, float normalisedValue)
+	{
+		if (parameter.getValue() != normalisedValue)
+			parameter.setValueNotifyingHost(normalisedValue);
+	}
+
+	void write(juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData)
+	{
+		juce::Array<juce::RangedAudioParameter*> parameters;
+
+		for (auto* parameter : apvts.processor.getParameters())
+		{
+			if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+				parameters.add(ranged);
+		}
+
+		juce::MemoryOutputStream output(destData, false);
+
+		output.writeInt((int)magic);
+		output.writeInt(currentVersion);
+		output.writeInt(parameters.size());
+
+		//values straight from the parameters, which may be ahead of the tree APVTS flushes on a timer
+		for (auto* parameter : parameters)
+		{
+			output.writeInt((int)hashParameterId(parameter->paramID));
+			output.writeFloat(parameter->convertFrom0to1(parameter->getValue()));
+		}
+
+		juce::ValueTree extras(apvts.state.getType());
+
+		for (const auto& child : apvts.state)
+		{
+			if (!child.hasType(parameterType))
+				extras.appendChild(child.createCopy(), nullptr);
+		}
+
+		juce::MemoryOutputStream extrasData;
+
+		if (extras.getNumChildren() > 0)
+			extras.writeToStream(extrasData);
+
+		output.writeInt((int)extrasData.getDataSize());
+		output.write(extrasData.getData(), extrasData.getDataSize());
+	}
+
+	bool isBinaryState(const void* data, int sizeInBytes)
+	{
+		return data != nullptr && sizeInBytes >= headerSize
+			&& juce::ByteOrder::littleEndianInt(data) == magic;
+	}
+
+	bool read(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes)
+	{
+		if (!isBinaryState(data, sizeInBytes))
+			return false;
+
+		juce::MemoryInputStream input(data, (size_t)sizeInBytes, false);
+		input.skipNextBytes(2 * sizeof(juce::uint32)); //magic and version, every version starts the same way
+
+		const auto numEntries = input.readInt();
+
+		//everything is checked before the first parameter moves, so a broken state changes nothing
+		if (numEntries < 0 || input.getNumBytesRemaining() < (juce::int64)numEntries * entrySize + (juce::int64)sizeof(juce::uint32))
+			return false;
+
+		const auto entriesStart = input.getPosition();
+		input.skipNextBytes((juce::int64)numEntries * entrySize);
+
+		const auto extrasSize = input.readInt();
+		if (extrasSize < 0 || input.getNumBytesRemaining() < extrasSize)
+			return false;
+
+		juce::Array<juce::RangedAudioParameter*> parameters;
+		juce::Array<juce::uint32> hashes;
+
+		for (auto* parameter : apvts.processor.getParameters())
+		{
+			if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+			{
+				parameters.add(ranged);
+				hashes.add(hashParameterId(ranged->paramID));
+			}
+		}
+
+		juce::Array<bool> restored;
+		restored.insertMultiple(0, false, parameters.size());
+
+		input.setPosition(entriesStart);
+
+		for (int entry = 0; entry < numEntries; ++entry)
+		{
+			const auto hash = (juce::uint32)input.readInt();
+			const auto value = input.readFloat();
+
+			//a state from the same build lines up entry for entry, anything else is looked up
+			auto index = entry < hashes.size() && hashes[entry] == hash ? entry : hashes.indexOf(hash);
+
+			//a parameter this build doesn't have, e.g. a band past numBands
+			if (index < 0)
+				continue;
+
+			auto* parameter = parameters[index];
+			setIfChanged(*parameter, parameter->convertTo0to1(value));
+			restored.set(index, true);
+		}
+
+		for (int i = 0; i < parameters.size(); ++i)
+		{
+			if (!restored[i])
+				setIfChanged(*parameters[i], parameters[i]->getDefaultValue());
+		}
+
+		if (extrasSize > 0)
+		{
+			auto extras = juce::ValueTree::readFromData(static_cast<const char*>(data) + input.getPosition(), (size_t)extrasSize);
+
+			for (const auto& child : extras)
+			{
+				auto existing = apvts.state.getChildWithName(child.getType());
+
+				if (existing.isValid())
+					existing.copyPropertiesAndChildrenFrom(child, nullptr);
+				else
+					apvts.state.appendChild(child.createCopy(), nullptr);
+			}
+		}
+
+		return true;
+	}
+}
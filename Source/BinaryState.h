@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    BinaryState.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Compact, versioned plugin state. A three word header, one (ID hash, value) pair per parameter in
+//the processor's parameter order, then the rest of the state tree (the analyzer options) as a small
+//ValueTree blob. Restoring sets the parameters straight from the pairs, with no tree to parse or
+//replace, and only touches parameters whose value actually differs.
+//
+//All words are little endian. Later versions only ever append, so an older build still restores
+//everything it knows about from a newer state.
+namespace BinaryState
+{
+	//"PEQ2" in the first four bytes; a ValueTree stream starts with its type name instead
+	constexpr juce::uint32 magic = 0x32514550;
+	constexpr int currentVersion = 1;
+
+	//FNV-1a of the UTF-8 ID, spelled out so it can never change between JUCE versions
+	juce::uint32 hashParameterId(const juce::String& parameterId);
+
+	void write(juce::AudioProcessorValueTreeState& apvts, juce::MemoryBlock& destData);
+
+	bool isBinaryState(const void* data, int sizeInBytes);
+
+	//Message thread. Parameters missing from the data go back to their defaults, like replaceState
+	//does. Returns false, having changed nothing, when the data is not in this format or is truncated.
+	bool read(juce::AudioProcessorValueTreeState& apvts, const void* data, int sizeInBytes);
+}
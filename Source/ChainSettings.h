@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+    ChainSettings.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <utility>
+
+//Number of EQ bands compiled into the plugin. Every per-band structure (processor chains,
+//coefficient sets, parameters, editor controls) is sized from this at compile time, so a
+//build with PARAMETRICEQ2_NUM_BANDS=16 carries no cost for bands a 3 band build doesn't have.
+#ifndef PARAMETRICEQ2_NUM_BANDS
+ #define PARAMETRICEQ2_NUM_BANDS 3
+#endif
+
+enum BandType
+{
+	LowPass,
+	Peak,
+	HighPass
+};
+
+enum Slope
+{
+	Slope_12,
+	Slope_24,
+	Slope_36,
+	Slope_48
+};
+
+enum FilterMode
+{
+	Biquad,
+	SmoothSvf,
+	LinearPhase
+};
+
+enum OversamplingQuality
+{
+	PolyphaseIir,
+	EquirippleFir
+};
+
+enum StereoMode
+{
+	Linked,
+	LeftRight,
+	MidSide
+};
+
+//Which of the first two channels a band runs on: left / right, or mid / side after encoding.
+//Channels past the first two only run bands set to both.
+enum BandChannels
+{
+	BothChannels,
+	LeftOrMid,
+	RightOrSide
+};
+
+inline bool isRoutedTo(BandChannels bandChannels, int channel)
+{
+	return bandChannels == BandChannels::BothChannels
+		|| (bandChannels == BandChannels::LeftOrMid && channel == 0)
+		|| (bandChannels == BandChannels::RightOrSide && channel == 1);
+}
+
+struct BandSettings
+{
+	float band_freq{ 0 };
+	float band_gain{ 0 };
+	Slope band_slope{ Slope::Slope_12 };
+	BandType band_type{ BandType::Peak };
+
+	//Dynamic mode, peak bands only: above the threshold the band's gain is pulled down by
+	//the overshoot times (1 - 1 / ratio), following a detector tuned to the band
+	bool band_dynamic{ false };
+	float band_threshold{ 0 };
+	float band_ratio{ 1 };
+	float band_attack{ 0 };
+	float band_release{ 0 };
+	//detect from the sidechain bus instead of the main input, when the host connects one
+	bool band_sidechain{ false };
+
+	//only used outside the linked stereo mode, see ChainSettings::getBandChannels
+	BandChannels band_channels{ BandChannels::BothChannels };
+
+	bool isDynamic() const { return band_dynamic && band_type == BandType::Peak; }
+};
+
+inline bool operator==(const BandSettings& lhs, const BandSettings& rhs)
+{
+	return lhs.band_freq == rhs.band_freq
+		&& lhs.band_gain == rhs.band_gain
+		&& lhs.band_slope == rhs.band_slope
+		&& lhs.band_type == rhs.band_type
+		&& lhs.band_dynamic == rhs.band_dynamic
+		&& lhs.band_threshold == rhs.band_threshold
+		&& lhs.band_ratio == rhs.band_ratio
+		&& lhs.band_attack == rhs.band_attack
+		&& lhs.band_release == rhs.band_release
+		&& lhs.band_sidechain == rhs.band_sidechain
+		&& lhs.band_channels == rhs.band_channels;
+}
+
+inline bool operator!=(const BandSettings& lhs, const BandSettings& rhs) { return !(lhs == rhs); }
+
+struct ChainSettings
+{
+	static constexpr int numBands = PARAMETRICEQ2_NUM_BANDS;
+	//ChainSettingsTracker reports changed bands as bits of an int
+	static_assert(numBands >= 1 && numBands <= 31, "PARAMETRICEQ2_NUM_BANDS must be between 1 and 31");
+
+	BandSettings bandSettings[numBands] = {};
+	FilterMode filterMode{ FilterMode::Biquad };
+	int oversamplingOrder{ 0 };
+	OversamplingQuality oversamplingQuality{ OversamplingQuality::PolyphaseIir };
+	StereoMode stereoMode{ StereoMode::Linked };
+
+	int getOversamplingFactor() const { return 1 << oversamplingOrder; }
+
+	BandChannels getBandChannels(int band) const
+	{
+		return stereoMode == StereoMode::Linked ? BandChannels::BothChannels : bandSettings[band].band_channels;
+	}
+};
+
+using BandIndices = std::make_index_sequence<ChainSettings::numBands>;
+
+//Builds one element per band in place, so non-copyable types like slider attachments can live in a std::array
+template<typename ElementType, typename Factory, size_t... Indices>
+std::array<ElementType, sizeof...(Indices)> makeBandArray(Factory&& factory, std::index_sequence<Indices...>)
+{
+	return { factory((int)Indices)... };
+}
+
+template<typename ElementType, typename Factory>
+std::array<ElementType, ChainSettings::numBands> makeBandArray(Factory&& factory)
+{
+	return makeBandArray<ElementType>(std::forward<Factory>(factory), BandIndices());
+}
+
+//Remembers the last designed settings so only the bands that actually moved get redesigned
+struct ChainSettingsTracker
+{
+	//Returns a bitmask with bit i set when band i needs new coefficients
+	int update(const ChainSettings& settings, double sampleRate)
+	{
+		int changedBands = 0;
+
+		for (int i = 0; i < ChainSettings::numBands; ++i)
+		{
+			if (!valid || sampleRate != lastSampleRate || settings.bandSettings[i] != lastSettings.bandSettings[i])
+				changedBands |= 1 << i;
+		}
+
+		lastSettings = settings;
+		lastSampleRate = sampleRate;
+		valid = true;
+
+		return changedBands;
+	}
+
+	void invalidate() { valid = false; }
+
+private:
+	ChainSettings lastSettings;
+	double lastSampleRate = 0.0;
+	bool valid = false;
+};
+
+inline auto makePeakFilter(const BandSettings& bandSettings, double sampleRate) {
+	return juce::dsp::IIR::Coefficients<float>::makePeakFilter(
+		sampleRate,
+		bandSettings.band_freq,
+		1.f,
+		juce::Decibels::decibelsToGain(bandSettings.band_gain)
+	);
+}
+
+inline auto makeLowPassFilter(const BandSettings& bandSettings, double sampleRate) {
+	return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(
+		bandSettings.band_freq,
+		sampleRate,
+		2 * (bandSettings.band_slope + 1)
+	);
+}
+
+inline auto makeHighPassFilter(const BandSettings& bandSettings, double sampleRate) {
+	return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(
+		bandSettings.band_freq,
+		sampleRate,
+		2 * (bandSettings.band_slope + 1)
+	);
+}
+
+juce::String getParameterId(int bandNumber, juce::String bandParameter);
+
+//Spreads the default band frequencies over 20 Hz..20 kHz with the middle of the range at 1 kHz,
+//which gives the original 20 Hz / 1 kHz / 20 kHz for three bands
+inline float getDefaultBandFrequency(int bandIndex)
+{
+	if (ChainSettings::numBands == 1)
+		return 1000.f;
+
+	auto position = (float)bandIndex / (float)(ChainSettings::numBands - 1);
+
+	auto freq = position <= 0.5f
+		? juce::mapToLog10(position * 2.f, 20.f, 1000.f)
+		: juce::mapToLog10(position * 2.f - 1.f, 1000.f, 20000.f);
+
+	return (float)juce::roundToInt(freq);
+}
@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    CoefficientDesigner.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientDesigner.h"
+
+static void copySection(const juce::dsp::IIR::Coefficients<float>& source, BiquadCoefficients& destination)
+{
+	jassert(source.getFilterOrder() == 2);
+
+	destination.b0 = source.coefficients[0];
+	destination.b1 = source.coefficients[1];
+	destination.b2 = source.coefficients[2];
+	destination.a1 = source.coefficients[3];
+	destination.a2 = source.coefficients[4];
+}
+
+BandCoefficients designBand(const BandSettings& bandSettings, double sampleRate)
+{
+	BandCoefficients band;
+
+	switch (bandSettings.band_type)
+	{
+	case BandType::LowPass:
+	case BandType::HighPass:
+	{
+		auto coefficients = bandSettings.band_type == BandType::LowPass
+			? makeLowPassFilter(bandSettings, sampleRate)
+			: makeHighPassFilter(bandSettings, sampleRate);
+
+		band.numSections = juce::jmin(coefficients.size(), BandCoefficients::maxSections);
+
+		for (int i = 0; i < band.numSections; ++i)
+			copySection(*coefficients[i], band.sections[i]);
+		break;
+	}
+	case BandType::Peak:
+	{
+		auto coefficients = makePeakFilter(bandSettings, sampleRate);
+
+		copySection(*coefficients, band.sections[0]);
+		band.numSections = 1;
+		break;
+	}
+	}
+
+	return band;
+}
+
+DynamicBandDesign designDynamics(const BandSettings& bandSettings, double filterSampleRate, double detectorSampleRate)
+{
+	DynamicBandDesign design;
+
+	if (!bandSettings.isDynamic())
+		return design;
+
+	design.enabled = true;
+	design.externalSidechain = bandSettings.band_sidechain;
+
+	//same Q as the peak filter, so the detector hears what the band acts on
+	auto detectorFreq = juce::jmin((double)bandSettings.band_freq, detectorSampleRate * 0.45);
+	copySection(*juce::dsp::IIR::Coefficients<float>::makeBandPass(detectorSampleRate, (float)detectorFreq, 1.f), design.detector);
+
+	auto getFollowerCoefficient = [detectorSampleRate](float timeMs)
+		{
+			return (float)std::exp(-1.0 / (juce::jmax(timeMs, 0.01f) * 0.001 * detectorSampleRate));
+		};
+
+	design.attackCoefficient = getFollowerCoefficient(bandSettings.band_attack);
+	design.releaseCoefficient = getFollowerCoefficient(bandSettings.band_release);
+	design.thresholdDb = bandSettings.band_threshold;
+	design.reductionPerDb = 1.f - 1.f / juce::jmax(bandSettings.band_ratio, 1.f);
+
+	auto omega = juce::MathConstants<double>::twoPi * bandSettings.band_freq / filterSampleRate;
+	design.staticGainDb = bandSettings.band_gain;
+	design.peakAlpha = (float)(std::sin(omega) / 2.0);
+	design.peakCosineTerm = (float)(-2.0 * std::cos(omega));
+
+	return design;
+}
+
+BiquadCoefficients makeDynamicPeakSection(const DynamicBandDesign& design, float gainDb)
+{
+	//A = sqrt(gain factor); Q is fixed at 1 like makePeakFilter is called with
+	auto A = std::exp(gainDb * (std::log(10.f) / 40.f));
+	auto alphaTimesA = design.peakAlpha * A;
+	auto alphaOverA = design.peakAlpha / A;
+	auto a0Inverse = 1.f / (1.f + alphaOverA);
+
+	BiquadCoefficients section;
+	section.b0 = (1.f + alphaTimesA) * a0Inverse;
+	section.b1 = design.peakCosineTerm * a0Inverse;
+	section.b2 = (1.f - alphaTimesA) * a0Inverse;
+	section.a1 = section.b1;
+	section.a2 = (1.f - alphaOverA) * a0Inverse;
+
+	return section;
+}
+
+bool isIdentity(const BiquadCoefficients& section)
+{
+	constexpr float tolerance = 1.0e-7f;
+
+	return std::abs(section.b0 - 1.f) < tolerance
+		&& std::abs(section.b1 - section.a1) < tolerance
+		&& std::abs(section.b2 - section.a2) < tolerance;
+}
+
+//Adjacent sections are deliberately not merged into higher order polynomials: in float
+//those lose precision quickly at low frequencies, cascaded biquads stay well conditioned
+CompiledCascade compileCascade(const CoefficientSet& coefficientSet)
+{
+	CompiledCascade cascade;
+
+	for (int band = 0; band < ChainSettings::numBands; ++band)
+	{
+		const auto& bandCoefficients = coefficientSet.bands[band];
+		//a dynamic band at 0 dB still has to be there for its gain to move
+		const auto isDynamic = coefficientSet.dynamics[band].enabled;
+
+		for (int i = 0; i < bandCoefficients.numSections; ++i)
+		{
+			if (!isDynamic && isIdentity(bandCoefficients.sections[i]))
+				continue;
+
+			cascade.sections[cascade.numSections] = bandCoefficients.sections[i];
+			cascade.slots[cascade.numSections] = band * BandCoefficients::maxSections + i;
+			cascade.channels[cascade.numSections] = coefficientSet.chainSettings.getBandChannels(band);
+			++cascade.numSections;
+		}
+	}
+
+	return cascade;
+}
+
+CoefficientSet designCoefficientSet(const ChainSettings& chainSettings, double hostSampleRate)
+{
+	CoefficientSet coefficientSet;
+
+	const auto rate = hostSampleRate * chainSettings.getOversamplingFactor();
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		coefficientSet.bands[i] = designBand(chainSettings.bandSettings[i], rate);
+		coefficientSet.dynamics[i] = designDynamics(chainSettings.bandSettings[i], rate, hostSampleRate);
+	}
+
+	coefficientSet.chainSettings = chainSettings;
+	coefficientSet.sampleRate = rate;
+	coefficientSet.cascade = compileCascade(coefficientSet);
+
+	return coefficientSet;
+}
+
+//==============================================================================
+CoefficientDesigner::CoefficientDesigner(juce::AudioProcessorValueTreeState& state, const ParameterHandles& parameterHandles)
+	: juce::Thread("Coefficient Designer"), apvts(state), parameters(parameterHandles)
+{
+	for (auto* param : apvts.processor.getParameters())
+	{
+		if (auto* paramWithId = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+			apvts.addParameterListener(paramWithId->paramID, this);
+	}
+}
+
+CoefficientDesigner::~CoefficientDesigner()
+{
+	stopThread(1000);
+
+	for (auto* param : apvts.processor.getParameters())
+	{
+		if (auto* paramWithId = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
+			apvts.removeParameterListener(paramWithId->paramID, this);
+	}
+}
+
+void CoefficientDesigner::prepare(double newSampleRate)
+{
+	{
+		const juce::ScopedLock sl(designLock);
+		sampleRate.store(newSampleRate);
+
+		//the audio side was reset, so it needs every band again even if nothing moved
+		chainSettingsTracker.invalidate();
+		needsUpdate.store(true);
+	}
+
+	design();
+	startThread();
+}
+
+void CoefficientDesigner::release()
+{
+	stopThread(1000);
+}
+
+void CoefficientDesigner::designIfNeeded()
+{
+	if (needsUpdate.load())
+		design();
+}
+
+void CoefficientDesigner::requestUpdate()
+{
+	needsUpdate.store(true);
+
+	//the editor, state restore and snapshot recall wake the thread at once. Signalling takes the
+	//event's lock, which the audio thread mustn't, so host automation waits for the next poll,
+	//at most maxIdleIntervalMs away.
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		notify();
+}
+
+void CoefficientDesigner::run()
+{
+	auto intervalMs = pollIntervalMs;
+
+	while (!threadShouldExit())
+	{
+		if (needsUpdate.load())
+		{
+			design();
+			intervalMs = pollIntervalMs;
+		}
+		else
+		{
+			intervalMs = juce::jmin(intervalMs * 2, maxIdleIntervalMs);
+		}
+
+		wait(intervalMs);
+	}
+}
+
+void CoefficientDesigner::parameterChanged(const juce::String& parameterID, float newValue)
+{
+	juce::ignoreUnused(parameterID, newValue);
+	requestUpdate();
+}
+
+void CoefficientDesigner::design()
+{
+	const juce::ScopedLock sl(designLock);
+
+	auto rate = sampleRate.load();
+	if (rate <= 0.0)
+		return;
+
+	//cleared before reading so a change arriving mid-design triggers another pass
+	needsUpdate.store(false);
+
+	//taken before the parameters are read: a set stamped later than a recall has seen that recall's values
+	workingSet.generation = ++generation;
+
+	auto chainSettings = parameters.getChainSettings();
+
+	//the filters run inside the oversampler, so they are designed at the oversampled rate;
+	//dynamics detectors listen to the input before it, at the host rate
+	const auto detectorRate = rate;
+	rate *= chainSettings.getOversamplingFactor();
+	auto changedBands = chainSettingsTracker.update(chainSettings, rate);
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		if (changedBands & (1 << i))
+		{
+			workingSet.bands[i] = designBand(chainSettings.bandSettings[i], rate);
+			workingSet.dynamics[i] = designDynamics(chainSettings.bandSettings[i], rate, detectorRate);
+		}
+	}
+
+	//a new stereo mode reroutes bands without changing their coefficients
+	const auto stereoModeChanged = chainSettings.stereoMode != workingSet.chainSettings.stereoMode;
+
+	workingSet.chainSettings = chainSettings;
+	workingSet.sampleRate = rate;
+
+	if (changedBands != 0 || stereoModeChanged)
+		workingSet.cascade = compileCascade(workingSet);
+
+	coefficientSets.getWriteBuffer() = workingSet;
+	coefficientSets.publish();
+
+	if (onSetPublished != nullptr)
+		onSetPublished(workingSet);
+}
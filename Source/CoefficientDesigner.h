@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    CoefficientDesigner.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+#include "ParameterHandles.h"
+#include "CoefficientSet.h"
+#include "TripleBuffer.h"
+
+//Watches the parameters from a background thread, designs the filters whenever they change
+//and publishes complete coefficient sets to the audio thread through a TripleBuffer
+class CoefficientDesigner : private juce::Thread,
+	private juce::AudioProcessorValueTreeState::Listener
+{
+public:
+	CoefficientDesigner(juce::AudioProcessorValueTreeState& apvts, const ParameterHandles& parameters);
+	~CoefficientDesigner() override;
+
+	//Designs a first set synchronously for the new sample rate and starts the background thread
+	void prepare(double sampleRate);
+	void release();
+
+	//Designs on the calling thread if anything changed, for offline rendering where the
+	//background thread would lag behind the automation
+	void designIfNeeded();
+
+	void requestUpdate();
+	//Audio thread: only flags the redesign, which the thread then picks up on its next poll. The
+	//audit and offline renders call processBlock on the message thread, where requestUpdate signals.
+	void requestUpdateWithoutWaking() { needsUpdate.store(true); }
+
+	double getSampleRate() const { return sampleRate.load(); }
+
+	//Called after the parameters were moved somewhere new in one go; every set designed from
+	//then on is stamped with a later generation than the one returned
+	juce::uint32 advanceGeneration() { return ++generation; }
+
+	//Audio thread only: newest set if one was published since the last call, nullptr otherwise
+	const CoefficientSet* acquire() { return coefficientSets.acquire(); }
+
+	//Called on the designing thread after every published set, for work that should stay off the audio thread
+	std::function<void(const CoefficientSet&)> onSetPublished;
+
+private:
+	void run() override;
+	void parameterChanged(const juce::String& parameterID, float newValue) override;
+	void design();
+
+	juce::AudioProcessorValueTreeState& apvts;
+	const ParameterHandles& parameters;
+
+	juce::CriticalSection designLock;
+	ChainSettingsTracker chainSettingsTracker;
+	CoefficientSet workingSet;
+	TripleBuffer<CoefficientSet> coefficientSets;
+
+	std::atomic<double> sampleRate{ 0.0 };
+	std::atomic<bool> needsUpdate{ true };
+	std::atomic<juce::uint32> generation{ 0 };
+
+	//polls quickly while things are moving and backs off while they aren't, halving the wakeups of
+	//idle instances in a big session. The cap bounds how late automation arriving on the audio
+	//thread, which can't signal the thread, is picked up after a quiet spell.
+	static constexpr int pollIntervalMs = 5;
+	static constexpr int maxIdleIntervalMs = 10;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CoefficientDesigner)
+};
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    CoefficientSet.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include "ChainSettings.h"
+
+//Normalised biquad (a0 == 1), same layout as juce::dsp::IIR::Coefficients raw data
+struct BiquadCoefficients
+{
+	float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+};
+
+struct BandCoefficients
+{
+	static constexpr int maxSections = 4;
+
+	std::array<BiquadCoefficients, maxSections> sections{};
+	int numSections = 0;
+};
+
+//The active sections of the whole chain packed back to back, so the audio loop never
+//visits bypassed stages or sections that leave the signal untouched (0 dB peaks)
+struct CompiledCascade
+{
+	static constexpr int maxSections = ChainSettings::numBands * BandCoefficients::maxSections;
+
+	std::array<BiquadCoefficients, maxSections> sections{};
+	//position of each packed section in the full band x section layout, used to keep its filter state
+	std::array<int, maxSections> slots{};
+	//the channels each packed section runs on; its band was designed once whatever the routing
+	std::array<BandChannels, maxSections> channels{};
+	int numSections = 0;
+};
+
+//Precomputed for a dynamic band so its gain can move every few samples without a full redesign
+struct DynamicBandDesign
+{
+	bool enabled = false;
+	bool externalSidechain = false;
+
+	//band-pass at the band frequency, at the host rate the detector runs at
+	BiquadCoefficients detector;
+	float attackCoefficient = 0.f;
+	float releaseCoefficient = 0.f;
+	float thresholdDb = 0.f;
+	//gain reduction per dB over the threshold, 1 - 1 / ratio
+	float reductionPerDb = 0.f;
+
+	//RBJ peak terms at the rate the filters run at: only A = 10^(gain / 40) changes with the gain
+	float staticGainDb = 0.f;
+	float peakAlpha = 0.f;
+	float peakCosineTerm = 0.f;
+};
+
+//Everything the audio thread needs to run the whole chain, designed off the audio thread
+struct CoefficientSet
+{
+	std::array<BandCoefficients, ChainSettings::numBands> bands{};
+	std::array<DynamicBandDesign, ChainSettings::numBands> dynamics{};
+	CompiledCascade cascade;
+	//the settings the set was designed from, also the smoothing targets for the SVF engine
+	ChainSettings chainSettings;
+	double sampleRate = 0.0;
+	//counts up with every set designed. Sets designed before a snapshot recall carry an older
+	//generation, so the audio thread can drop them; linear phase kernels are matched to sets by it.
+	juce::uint32 generation = 0;
+};
+
+BandCoefficients designBand(const BandSettings& bandSettings, double sampleRate);
+
+DynamicBandDesign designDynamics(const BandSettings& bandSettings, double filterSampleRate, double detectorSampleRate);
+
+//Same section makePeakFilter would design at this gain, for a handful of multiplies and one divide
+BiquadCoefficients makeDynamicPeakSection(const DynamicBandDesign& design, float gainDb);
+
+bool isIdentity(const BiquadCoefficients& section);
+
+CompiledCascade compileCascade(const CoefficientSet& coefficientSet);
+
+//Designs every band from scratch. hostSampleRate is the rate the processor runs at; the filters
+//are designed at the oversampled rate the settings ask for, like the designer thread does.
+CoefficientSet designCoefficientSet(const ChainSettings& chainSettings, double hostSampleRate);
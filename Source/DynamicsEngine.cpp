@@ -0,0 +1,187 @@
+/*
+  ==============================================================================
+
+    DynamicsEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "DynamicsEngine.h"
+
+void DynamicsEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+	juce::ignoreUnused(spec);
+
+	//the processor hands over one sub block at a time
+	mainDetectorInput.assign((size_t)subBlockSize, 0.f);
+	sidechainDetectorInput.assign((size_t)subBlockSize, 0.f);
+
+	//lanes past the last band are never designed, they just run silence
+	const auto zero = Register::expand(0.f);
+	for (auto& group : groups)
+		group = { zero, zero, zero, zero, zero, zero, zero, zero, zero, zero, zero, zero, zero };
+
+	reset();
+}
+
+void DynamicsEngine::reset()
+{
+	for (auto& group : groups)
+	{
+		group.s1 = Register::expand(0.f);
+		group.s2 = Register::expand(0.f);
+		group.envelope = Register::expand(0.f);
+	}
+
+	for (int band = 0; band < ChainSettings::numBands; ++band)
+	{
+		gainDb[band] = designs[band].staticGainDb;
+		gainChanged[band] = designs[band].enabled;
+	}
+}
+
+void DynamicsEngine::setDesign(const CoefficientSet& coefficientSet)
+{
+	numActiveBands = 0;
+	inputIsMidSide = coefficientSet.chainSettings.stereoMode == StereoMode::MidSide;
+
+	for (int band = 0; band < ChainSettings::numBands; ++band)
+	{
+		const auto& design = coefficientSet.dynamics[band];
+		auto& group = groups[band / bandsPerGroup];
+		const auto lane = (size_t)(band % bandsPerGroup);
+
+		//a band switching dynamics on starts from a quiet detector rather than stale state
+		if (!design.enabled || !designs[band].enabled)
+		{
+			group.s1.set(lane, 0.f);
+			group.s2.set(lane, 0.f);
+			group.envelope.set(lane, 0.f);
+		}
+
+		designs[band] = design;
+
+		group.b0.set(lane, design.detector.b0);
+		group.b1.set(lane, design.detector.b1);
+		group.b2.set(lane, design.detector.b2);
+		group.a1.set(lane, design.detector.a1);
+		group.a2.set(lane, design.detector.a2);
+		group.attack.set(lane, design.attackCoefficient);
+		group.release.set(lane, design.releaseCoefficient);
+		group.sidechainMix.set(lane, design.externalSidechain ? 1.f : 0.f);
+
+		const auto channels = coefficientSet.chainSettings.getBandChannels(band);
+		group.firstChannelMix.set(lane, channels == BandChannels::LeftOrMid ? 1.f : 0.f);
+		group.secondChannelMix.set(lane, channels == BandChannels::RightOrSide ? 1.f : 0.f);
+
+		//the new set carries the static coefficients, so the dynamic gain has to go in again
+		gainChanged[band] = design.enabled;
+
+		if (design.enabled)
+			++numActiveBands;
+	}
+}
+
+void DynamicsEngine::mixToMono(const juce::dsp::AudioBlock<float>& block, float* destination)
+{
+	const auto numChannels = (int)block.getNumChannels();
+	const auto numSamples = (int)block.getNumSamples();
+
+	juce::FloatVectorOperations::copy(destination, block.getChannelPointer(0), numSamples);
+
+	for (int channel = 1; channel < numChannels; ++channel)
+		juce::FloatVectorOperations::add(destination, block.getChannelPointer((size_t)channel), numSamples);
+
+	if (numChannels > 1)
+		juce::FloatVectorOperations::multiply(destination, 1.f / (float)numChannels, numSamples);
+}
+
+void DynamicsEngine::analyse(const juce::dsp::AudioBlock<float>& input, const juce::dsp::AudioBlock<float>& sidechain)
+{
+	const auto numSamples = (int)input.getNumSamples();
+	jassert(numSamples <= subBlockSize);
+
+	if (numActiveBands == 0 || numSamples == 0 || input.getNumChannels() == 0)
+		return;
+
+	const auto numChannels = (int)input.getNumChannels();
+	const auto* firstChannelSamples = input.getChannelPointer(0);
+	const auto* secondChannelSamples = input.getChannelPointer((size_t)juce::jmin(1, numChannels - 1));
+
+	const float* mainSamples = firstChannelSamples;
+	if (!inputIsMidSide || numChannels < 2)
+	{
+		mixToMono(input, mainDetectorInput.data());
+		mainSamples = mainDetectorInput.data();
+	}
+
+	const auto* sidechainSamples = mainSamples;
+
+	if (sidechain.getNumChannels() > 0)
+	{
+		mixToMono(sidechain, sidechainDetectorInput.data());
+		sidechainSamples = sidechainDetectorInput.data();
+	}
+
+	for (auto& group : groups)
+	{
+		auto s1 = group.s1;
+		auto s2 = group.s2;
+		auto envelope = group.envelope;
+
+		for (int i = 0; i < numSamples; ++i)
+		{
+			auto mixed = Register::expand(mainSamples[i]);
+			auto mainSample = mixed
+				+ group.firstChannelMix * (Register::expand(firstChannelSamples[i]) - mixed)
+				+ group.secondChannelMix * (Register::expand(secondChannelSamples[i]) - mixed);
+			auto x = mainSample + group.sidechainMix * (Register::expand(sidechainSamples[i]) - mainSample);
+
+			//transposed direct form II, like the main engine
+			auto y = group.b0 * x + s1;
+			s1 = group.b1 * x - group.a1 * y + s2;
+			s2 = group.b2 * x - group.a2 * y;
+
+			auto rectified = Register::abs(y);
+			auto rising = Register::greaterThan(rectified, envelope);
+			auto coefficient = (group.attack & rising) + (group.release & ~rising);
+
+			envelope = rectified + coefficient * (envelope - rectified);
+		}
+
+		group.s1 = s1;
+		group.s2 = s2;
+		group.envelope = envelope;
+	}
+
+	//block rate from here on: one log and a few multiplies per band
+	constexpr float minChangeDb = 0.05f;
+
+	for (int band = 0; band < ChainSettings::numBands; ++band)
+	{
+		const auto& design = designs[band];
+		if (!design.enabled)
+			continue;
+
+		auto level = groups[band / bandsPerGroup].envelope.get((size_t)(band % bandsPerGroup));
+		auto overshootDb = juce::Decibels::gainToDecibels(level, -100.f) - design.thresholdDb;
+		auto reductionDb = juce::jlimit(0.f, maxReductionDb, overshootDb * design.reductionPerDb);
+		auto newGainDb = design.staticGainDb - reductionDb;
+
+		if (gainChanged[band] || std::abs(newGainDb - gainDb[band]) > minChangeDb)
+		{
+			gainDb[band] = newGainDb;
+			gainChanged[band] = true;
+		}
+	}
+}
+
+bool DynamicsEngine::takeGainChange(int band, float& newGainDb)
+{
+	if (!gainChanged[band])
+		return false;
+
+	gainChanged[band] = false;
+	newGainDb = gainDb[band];
+	return true;
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    DynamicsEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientSet.h"
+
+//Detector side of the dynamic bands. Every band gets a band-pass detector and a peak envelope
+//follower; the bands sit in the lanes of a SIMD register so one pass runs all of them. The
+//envelopes are turned into gain changes once per sub block, which the filter engines apply
+//through their cheap per band coefficient paths.
+class DynamicsEngine
+{
+public:
+	using Register = juce::dsp::SIMDRegister<float>;
+
+	static constexpr int bandsPerGroup = (int)Register::SIMDNumElements;
+	static constexpr int numGroups = (ChainSettings::numBands + bandsPerGroup - 1) / bandsPerGroup;
+
+	//host rate samples between gain updates
+	static constexpr int subBlockSize = 32;
+	//deepest cut a dynamic band will make below its static gain
+	static constexpr float maxReductionDb = 24.f;
+
+	void prepare(const juce::dsp::ProcessSpec& spec);
+	void reset();
+
+	//Audio thread safe, only copies and broadcasts the precomputed designs
+	void setDesign(const CoefficientSet& coefficientSet);
+
+	bool isActive() const { return numActiveBands > 0; }
+
+	//Runs the detectors over one sub block of host rate input. The sidechain block may have no
+	//channels, in which case bands set to the sidechain listen to the main input instead.
+	void analyse(const juce::dsp::AudioBlock<float>& input, const juce::dsp::AudioBlock<float>& sidechain);
+
+	//True when the band's gain moved since it was last taken, or a new design arrived
+	bool takeGainChange(int band, float& gainDb);
+
+	const DynamicBandDesign& getDesign(int band) const { return designs[(size_t)band]; }
+
+private:
+	struct Group
+	{
+		Register b0, b1, b2, a1, a2;
+		Register attack, release;
+		//1 in the lanes of bands routed to the first or second channel, which detect from that
+		//channel alone; bands on both channels detect from the mono mix
+		Register firstChannelMix, secondChannelMix;
+		//1 in the lanes that detect from the sidechain, 0 elsewhere
+		Register sidechainMix;
+
+		Register s1, s2, envelope;
+	};
+
+	static void mixToMono(const juce::dsp::AudioBlock<float>& block, float* destination);
+
+	std::array<Group, numGroups> groups;
+	std::array<DynamicBandDesign, ChainSettings::numBands> designs{};
+	std::array<float, ChainSettings::numBands> gainDb{};
+	std::array<bool, ChainSettings::numBands> gainChanged{};
+	int numActiveBands = 0;
+	//after mid / side encoding the mid channel already is the mono mix
+	bool inputIsMidSide = false;
+
+	std::vector<float> mainDetectorInput, sidechainDetectorInput;
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    HalfbandDecimator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Streaming decimate by two behind a windowed sinc halfband lowpass. Every other tap of a
+//halfband is zero and the rest are symmetric, so each output costs numPairs + 1 multiplies.
+//Flat to well past a quarter of the output band, which is all the multirate analyzer uses
+//of a decimated stage; whatever folds back into that range starts in the stopband.
+class HalfbandDecimator
+{
+public:
+	static constexpr int numPairs = 12;
+	static constexpr int numTaps = 4 * numPairs - 1;
+	static constexpr int centre = numTaps / 2;
+
+	void reset()
+	{
+		delayLine.fill(0.f);
+		position = 0;
+		outputDue = false;
+	}
+
+	//Takes one input sample, returns true when it also produced an output sample
+	bool process(float input, float& output)
+	{
+		delayLine[(size_t)position] = input;
+		delayLine[(size_t)(position + numTaps)] = input;
+		position = position == numTaps - 1 ? 0 : position + 1;
+
+		outputDue = !outputDue;
+		if (!outputDue)
+			return false;
+
+		//the newest numTaps samples, contiguous thanks to the doubled delay line
+		const auto* window = delayLine.data() + position;
+		const auto& taps = getTaps();
+
+		auto sum = taps.centre * window[centre];
+		for (int p = 0; p < numPairs; ++p)
+		{
+			auto offset = 2 * p + 1;
+			sum += taps.pairs[(size_t)p] * (window[centre - offset] + window[centre + offset]);
+		}
+
+		output = sum;
+		return true;
+	}
+
+private:
+	struct Taps
+	{
+		float centre = 0.5f;
+		//the non zero taps on one side of the centre, at odd offsets 1, 3, 5...
+		std::array<float, numPairs> pairs{};
+	};
+
+	static const Taps& getTaps()
+	{
+		static const auto taps = []
+			{
+				Taps result;
+				std::array<double, numPairs> pairs{};
+				double sum = 0.5;
+
+				for (int p = 0; p < numPairs; ++p)
+				{
+					auto n = (double)(2 * p + 1);
+					auto sinc = std::sin(juce::MathConstants<double>::halfPi * n) / (juce::MathConstants<double>::pi * n);
+					auto phase = juce::MathConstants<double>::pi * n / (centre + 1);
+					auto blackman = 0.42 + 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+
+					pairs[(size_t)p] = sinc * blackman;
+					sum += 2.0 * pairs[(size_t)p];
+				}
+
+				//unity gain at DC
+				result.centre = (float)(0.5 / sum);
+				for (int p = 0; p < numPairs; ++p)
+					result.pairs[(size_t)p] = (float)(pairs[(size_t)p] / sum);
+
+				return result;
+			}();
+
+		return taps;
+	}
+
+	std::array<float, numTaps * 2> delayLine{};
+	int position = 0;
+	bool outputDue = false;
+};
@@ -0,0 +1,274 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEngine.h"
+
+static bool isSameCascade(const CompiledCascade& lhs, const CompiledCascade& rhs)
+{
+	if (lhs.numSections != rhs.numSections)
+		return false;
+
+	for (int i = 0; i < lhs.numSections; ++i)
+	{
+		const auto& a = lhs.sections[i];
+		const auto& b = rhs.sections[i];
+
+		if (a.b0 != b.b0 || a.b1 != b.b1 || a.b2 != b.b2 || a.a1 != b.a1 || a.a2 != b.a2)
+			return false;
+
+		if (lhs.channels[i] != rhs.channels[i])
+			return false;
+	}
+
+	return true;
+}
+
+static bool isRoutedPerChannel(const CompiledCascade& cascade)
+{
+	for (int i = 0; i < cascade.numSections; ++i)
+	{
+		if (cascade.channels[i] != BandChannels::BothChannels)
+			return true;
+	}
+
+	return false;
+}
+
+static double getCascadeMagnitude(const CompiledCascade& cascade, double freq, double sampleRate, int channel)
+{
+	auto w = juce::MathConstants<double>::twoPi * freq / sampleRate;
+	std::complex<double> z1 = std::polar(1.0, -w);
+	std::complex<double> z2 = z1 * z1;
+
+	double magnitude = 1.0;
+
+	for (int i = 0; i < cascade.numSections; ++i)
+	{
+		if (!isRoutedTo(cascade.channels[i], channel))
+			continue;
+
+		const auto& section = cascade.sections[i];
+		auto numerator = (double)section.b0 + (double)section.b1 * z1 + (double)section.b2 * z2;
+		auto denominator = 1.0 + (double)section.a1 * z1 + (double)section.a2 * z2;
+
+		magnitude *= std::abs(numerator) / std::abs(denominator);
+	}
+
+	return magnitude;
+}
+
+//==============================================================================
+LinearPhaseEngine::LinearPhaseEngine()
+{
+}
+
+LinearPhaseEngine::~LinearPhaseEngine()
+{
+}
+
+int LinearPhaseEngine::getKernelLengthFor(double sampleRate)
+{
+	return juce::jlimit(8192, 65536, juce::nextPowerOfTwo(juce::roundToInt(sampleRate * kernelLengthSeconds)));
+}
+
+void LinearPhaseEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+	const juce::ScopedLock sl(kernelLock);
+
+	sampleRate = spec.sampleRate;
+	kernelLength.store(getKernelLengthFor(sampleRate));
+	lastCascade = {};
+	lastDesignSampleRate = 0.0;
+	requestedKernelSize.store(0);
+	requestedGeneration.store(0);
+	installedKernelSize.store(0);
+	deferredRequest.store(false);
+
+	silence.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+	convolutions.clear();
+	firstPairChannels = (int)juce::jmin(2u, spec.numChannels);
+
+	for (juce::uint32 firstChannel = 0; firstChannel < spec.numChannels; firstChannel += 2)
+	{
+		auto pairSpec = spec;
+		pairSpec.numChannels = juce::jmin(2u, spec.numChannels - firstChannel);
+
+		auto convolution = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::NonUniform{ headSize }, messageQueue);
+		convolution->prepare(pairSpec);
+		convolutions.push_back(std::move(convolution));
+	}
+}
+
+void LinearPhaseEngine::reset()
+{
+	for (auto& convolution : convolutions)
+		convolution->reset();
+}
+
+void LinearPhaseEngine::updateKernel(const CoefficientSet& coefficientSet)
+{
+	const juce::ScopedLock sl(kernelLock);
+
+	if (sampleRate <= 0.0 || convolutions.empty())
+		return;
+
+	//the kernel already on its way serves this set just as well
+	if (coefficientSet.sampleRate == lastDesignSampleRate && isSameCascade(coefficientSet.cascade, lastCascade))
+	{
+		requestedGeneration.store(coefficientSet.generation);
+		return;
+	}
+
+	//loading over a kernel in flight could bring its stamp round again before it lands. The set
+	//stays unrequested, so the processor keeps waiting, and the newest one is loaded later.
+	if (isKernelInFlight())
+	{
+		deferredRequest.store(true);
+		return;
+	}
+
+	lastCascade = coefficientSet.cascade;
+	lastDesignSampleRate = coefficientSet.sampleRate;
+
+	const auto length = kernelLength.load();
+	kernelStamp = (kernelStamp + 1) % numKernelStamps;
+	const auto kernelSize = length + kernelStamp;
+
+	//the size goes first, so the audio thread never pairs this generation with an older kernel
+	requestedKernelSize.store(kernelSize);
+	requestedGeneration.store(coefficientSet.generation);
+
+	auto loadKernel = [this](juce::dsp::Convolution& convolution, juce::AudioBuffer<float> kernel)
+		{
+			auto stereo = kernel.getNumChannels() == 2 ? juce::dsp::Convolution::Stereo::yes : juce::dsp::Convolution::Stereo::no;
+
+			convolution.loadImpulseResponse(std::move(kernel),
+				sampleRate,
+				stereo,
+				juce::dsp::Convolution::Trim::no,
+				juce::dsp::Convolution::Normalise::no);
+		};
+
+	//the first pair only needs kernels of its own when some band is routed to one of its channels,
+	//channel 2 and up only ever run the bands set to both channels
+	const auto routedPerChannel = isRoutedPerChannel(coefficientSet.cascade);
+
+	if (!routedPerChannel || convolutions.size() > 1)
+	{
+		constexpr int sharedChannel = 2;
+		juce::AudioBuffer<float> sharedKernel(1, kernelSize);
+		sharedKernel.clear();
+		generateKernel(coefficientSet.cascade, coefficientSet.sampleRate, sharedChannel, sharedKernel, 0);
+
+		for (size_t pair = routedPerChannel ? 1 : 0; pair < convolutions.size(); ++pair)
+			loadKernel(*convolutions[pair], sharedKernel);
+	}
+
+	if (!routedPerChannel)
+		return;
+
+	juce::AudioBuffer<float> firstPairKernel(firstPairChannels, kernelSize);
+	firstPairKernel.clear();
+	for (int channel = 0; channel < firstPairChannels; ++channel)
+		generateKernel(coefficientSet.cascade, coefficientSet.sampleRate, channel, firstPairKernel, channel);
+
+	loadKernel(*convolutions[0], std::move(firstPairKernel));
+}
+
+void LinearPhaseEngine::generateKernel(const CompiledCascade& cascade, double designSampleRate, int channel,
+	juce::AudioBuffer<float>& kernel, int kernelChannel)
+{
+	//the kernel may be longer by its stamp, those taps stay zero
+	const auto length = kernelLength.load();
+	const auto order = juce::roundToInt(std::log2((double)length));
+	jassert((1 << order) == length);
+
+	//zero phase spectrum: the magnitude the minimum phase filters would have. Designing at
+	//the oversampled rate and sampling only up to our own Nyquist avoids the BLT cramping.
+	std::vector<std::complex<float>> spectrum((size_t)length);
+	std::vector<std::complex<float>> impulse((size_t)length);
+
+	for (int bin = 0; bin <= length / 2; ++bin)
+	{
+		auto freq = bin * sampleRate / length;
+		auto magnitude = (float)getCascadeMagnitude(cascade, freq, designSampleRate, channel);
+
+		spectrum[(size_t)bin] = magnitude;
+		if (bin > 0 && bin < length / 2)
+			spectrum[(size_t)(length - bin)] = magnitude;
+	}
+
+	juce::dsp::FFT fft(order);
+	fft.perform(spectrum.data(), impulse.data(), true);
+
+	//centre the zero phase response and taper the ends to keep truncation ripple down. The response
+	//sits on tap length / 2, so the window has length + 1 points to be symmetric about that tap too;
+	//its last point is dropped, and tap 0, the one without a partner, gets a weight of zero.
+	std::vector<float> window((size_t)length + 1);
+	juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), (size_t)length + 1,
+		juce::dsp::WindowingFunction<float>::blackman, false);
+
+	auto* data = kernel.getWritePointer(kernelChannel);
+	for (int i = 0; i < length; ++i)
+	{
+		auto source = (i + length / 2) % length;
+		data[i] = impulse[(size_t)source].real() * window[(size_t)i];
+	}
+}
+
+bool LinearPhaseEngine::isKernelLoaded(juce::uint32 generation) const
+{
+	//the set is published before its kernel is requested, so there may be nothing to wait on yet
+	if (requestedGeneration.load() < generation)
+		return false;
+
+	const auto kernelSize = requestedKernelSize.load();
+	return kernelSize > 0 && installedKernelSize.load() == kernelSize;
+}
+
+bool LinearPhaseEngine::takeDeferredRequest()
+{
+	return !isKernelInFlight() && deferredRequest.load() && deferredRequest.exchange(false);
+}
+
+void LinearPhaseEngine::processSilence(int numSamples)
+{
+	numSamples = juce::jmin(numSamples, silence.getNumSamples());
+	silence.clear();
+
+	process(juce::dsp::AudioBlock<float>(silence).getSubBlock(0, (size_t)numSamples));
+}
+
+void LinearPhaseEngine::process(const juce::dsp::AudioBlock<float>& block)
+{
+	const auto numChannels = block.getNumChannels();
+
+	for (size_t pair = 0; pair < convolutions.size(); ++pair)
+	{
+		auto firstChannel = pair * 2;
+		if (firstChannel >= numChannels)
+			break;
+
+		auto pairBlock = block.getSubsetChannelBlock(firstChannel, juce::jmin((size_t)2, numChannels - firstChannel));
+		juce::dsp::ProcessContextReplacing<float> context(pairBlock);
+		convolutions[pair]->process(context);
+	}
+
+	//new kernels are installed while processing, so this is where the one in flight shows up
+	const auto kernelSize = requestedKernelSize.load();
+	if (kernelSize != installedKernelSize.load())
+	{
+		auto allInstalled = !convolutions.empty();
+		for (auto& convolution : convolutions)
+			allInstalled = allInstalled && convolution->getCurrentIRSize() == kernelSize;
+
+		if (allInstalled)
+			installedKernelSize.store(kernelSize);
+	}
+}
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientSet.h"
+
+//Applies the combined magnitude response of all bands as a symmetric FIR kernel. When bands
+//are routed to one of the first two channels, that pair gets a stereo kernel instead.
+//The kernel is regenerated off the audio thread and handed to juce::dsp::Convolution,
+//which runs it as a non uniformly partitioned FFT convolution and crossfades between
+//the old and new kernel when it swaps them in.
+class LinearPhaseEngine
+{
+public:
+	LinearPhaseEngine();
+	~LinearPhaseEngine();
+
+	void prepare(const juce::dsp::ProcessSpec& spec);
+	void reset();
+
+	//Background thread: rebuilds the kernel if the cascade differs from the last one. While the
+	//previous kernel is still on its way to the convolutions nothing is loaded; the request is
+	//held back until takeDeferredRequest hands it to the caller.
+	void updateKernel(const CoefficientSet& coefficientSet);
+
+	//Audio thread: true, once, when a request was held back and the kernel it waited on is now
+	//running. The caller then asks for a fresh design, which brings the latest set back here.
+	bool takeDeferredRequest();
+
+	void process(const juce::dsp::AudioBlock<float>& block);
+
+	//Audio thread: true once every convolution runs the kernel requested for the set with this
+	//generation, or for a later one
+	bool isKernelLoaded(juce::uint32 generation) const;
+
+	//Audio thread: a convolution only installs a newly loaded kernel while it processes, so this
+	//runs silence through them while the processor waits to switch over
+	void processSilence(int numSamples);
+
+	//half the kernel length, the kernel is centred on its middle tap
+	int getLatencySamples() const { return kernelLength.load() / 2; }
+
+	static int getKernelLengthFor(double sampleRate);
+
+private:
+	//magnitude of the sections that run on the given channel, written to one channel of the kernel
+	void generateKernel(const CompiledCascade& cascade, double designSampleRate, int channel,
+		juce::AudioBuffer<float>& kernel, int kernelChannel);
+
+	juce::dsp::ConvolutionMessageQueue messageQueue;
+	//juce::dsp::Convolution handles at most two channels, so channels are run in pairs
+	std::vector<std::unique_ptr<juce::dsp::Convolution>> convolutions;
+
+	juce::CriticalSection kernelLock;
+	CompiledCascade lastCascade;
+	double lastDesignSampleRate = 0.0;
+	double sampleRate = 0.0;
+	int firstPairChannels = 0;
+	std::atomic<int> kernelLength{ 0 };
+	juce::AudioBuffer<float> silence;
+
+	//juce::dsp::Convolution only reports the size of the kernel it runs, so every kernel loaded
+	//gets 0 to numKernelStamps - 1 trailing zero taps, and the size then tells them apart. A load
+	//only starts once the one before it is running, so a stamp never comes round again while a
+	//kernel carrying it could still be in flight.
+	static constexpr int numKernelStamps = 16;
+	int kernelStamp = 0;
+	std::atomic<int> requestedKernelSize{ 0 };
+	std::atomic<juce::uint32> requestedGeneration{ 0 };
+	//size of the requested kernel once every convolution runs it, set by the audio thread
+	std::atomic<int> installedKernelSize{ 0 };
+	std::atomic<bool> deferredRequest{ false };
+
+	bool isKernelInFlight() const { return installedKernelSize.load() != requestedKernelSize.load(); }
+
+	static constexpr int headSize = 512;
+	static constexpr double kernelLengthSeconds = 0.17;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LinearPhaseEngine)
+};
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    MidSideMatrix.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//In place mid / side conversion of the first two channels of a block, a few vectorised
+//passes each with no scratch buffer. mid = (L + R) / 2, side = (L - R) / 2, so decoding
+//is L = mid + side, R = mid - side and an untouched signal comes back to within float rounding.
+namespace MidSideMatrix
+{
+	inline void encode(const juce::dsp::AudioBlock<float>& block)
+	{
+		if (block.getNumChannels() < 2)
+			return;
+
+		auto* left = block.getChannelPointer(0);
+		auto* right = block.getChannelPointer(1);
+		const auto numSamples = (int)block.getNumSamples();
+
+		juce::FloatVectorOperations::add(left, right, numSamples);
+		juce::FloatVectorOperations::multiply(left, 0.5f, numSamples);
+		//right becomes mid - right, which is (L - R) / 2
+		juce::FloatVectorOperations::subtract(right, left, right, numSamples);
+	}
+
+	inline void decode(const juce::dsp::AudioBlock<float>& block)
+	{
+		if (block.getNumChannels() < 2)
+			return;
+
+		auto* mid = block.getChannelPointer(0);
+		auto* side = block.getChannelPointer(1);
+		const auto numSamples = (int)block.getNumSamples();
+
+		juce::FloatVectorOperations::add(mid, side, numSamples);
+		//side becomes (mid + side) - 2 side, which is the right channel
+		juce::FloatVectorOperations::multiply(side, -2.f, numSamples);
+		juce::FloatVectorOperations::add(side, mid, numSamples);
+	}
+}
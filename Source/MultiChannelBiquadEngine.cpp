@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+    MultiChannelBiquadEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "MultiChannelBiquadEngine.h"
+
+void MultiChannelBiquadEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+	maxBlockSize = (int)spec.maximumBlockSize;
+	numGroups = ((int)spec.numChannels + channelsPerGroup - 1) / channelsPerGroup;
+
+	interleaved.assign((size_t)(numGroups * maxBlockSize), Register::expand(0.f));
+	state1.resize((size_t)numGroups);
+	state2.resize((size_t)numGroups);
+
+	reset();
+}
+
+void MultiChannelBiquadEngine::reset()
+{
+	for (int group = 0; group < numGroups; ++group)
+	{
+		state1[group].fill(Register::expand(0.f));
+		state2[group].fill(Register::expand(0.f));
+	}
+}
+
+void MultiChannelBiquadEngine::setCoefficients(const CoefficientSet& coefficientSet)
+{
+	const auto& cascade = coefficientSet.cascade;
+	std::array<bool, maxSections> slotInUse{};
+	bandSectionIndices.fill(-1);
+
+	for (int i = 0; i < cascade.numSections; ++i)
+	{
+		sectionChannels[i] = cascade.channels[i];
+		loadSection(i, cascade.sections[i]);
+
+		sectionSlots[i] = cascade.slots[i];
+		slotInUse[cascade.slots[i]] = true;
+
+		if (cascade.slots[i] % BandCoefficients::maxSections == 0)
+			bandSectionIndices[cascade.slots[i] / BandCoefficients::maxSections] = i;
+	}
+
+	numSections = cascade.numSections;
+
+	//a section that drops out starts again from silence, like a freshly reset filter
+	for (int slot = 0; slot < maxSections; ++slot)
+	{
+		if (slotInUse[slot])
+			continue;
+
+		for (int group = 0; group < numGroups; ++group)
+		{
+			state1[group][slot] = Register::expand(0.f);
+			state2[group][slot] = Register::expand(0.f);
+		}
+	}
+}
+
+void MultiChannelBiquadEngine::setBandSection(int band, const BiquadCoefficients& coefficients)
+{
+	auto index = bandSectionIndices[band];
+
+	if (index >= 0)
+		loadSection(index, coefficients);
+}
+
+void MultiChannelBiquadEngine::loadSection(int index, const BiquadCoefficients& source)
+{
+	const auto channels = sectionChannels[index];
+	const BiquadCoefficients identity;
+
+	//a section on one channel only passes the other lanes through untouched
+	auto& firstGroupSection = firstGroupSections[index];
+	for (int lane = 0; lane < channelsPerGroup; ++lane)
+	{
+		const auto& laneCoefficients = isRoutedTo(channels, lane) ? source : identity;
+
+		firstGroupSection.b0.set((size_t)lane, laneCoefficients.b0);
+		firstGroupSection.b1.set((size_t)lane, laneCoefficients.b1);
+		firstGroupSection.b2.set((size_t)lane, laneCoefficients.b2);
+		firstGroupSection.a1.set((size_t)lane, laneCoefficients.a1);
+		firstGroupSection.a2.set((size_t)lane, laneCoefficients.a2);
+	}
+
+	const auto& shared = channels == BandChannels::BothChannels ? source : identity;
+	auto& section = sections[index];
+
+	section.b0 = Register::expand(shared.b0);
+	section.b1 = Register::expand(shared.b1);
+	section.b2 = Register::expand(shared.b2);
+	section.a1 = Register::expand(shared.a1);
+	section.a2 = Register::expand(shared.a2);
+}
+
+void MultiChannelBiquadEngine::process(const juce::dsp::AudioBlock<float>& block)
+{
+	if (numSections == 0)
+		return;
+
+	const auto numChannels = (int)block.getNumChannels();
+	const auto totalNumSamples = (int)block.getNumSamples();
+	const auto groupsToProcess = juce::jmin(numGroups, (numChannels + channelsPerGroup - 1) / channelsPerGroup);
+
+	for (int start = 0; start < totalNumSamples; start += maxBlockSize)
+	{
+		const auto numSamples = juce::jmin(maxBlockSize, totalNumSamples - start);
+
+		for (int group = 0; group < groupsToProcess; ++group)
+		{
+			const auto firstChannel = group * channelsPerGroup;
+			const auto channelsInGroup = juce::jmin(channelsPerGroup, numChannels - firstChannel);
+			auto* laneData = reinterpret_cast<float*>(interleaved.data() + group * maxBlockSize);
+
+			for (int lane = 0; lane < channelsInGroup; ++lane)
+			{
+				const auto* input = block.getChannelPointer((size_t)(firstChannel + lane)) + start;
+
+				for (int i = 0; i < numSamples; ++i)
+					laneData[i * channelsPerGroup + lane] = input[i];
+			}
+
+			processGroup(group, numSamples);
+
+			for (int lane = 0; lane < channelsInGroup; ++lane)
+			{
+				auto* output = block.getChannelPointer((size_t)(firstChannel + lane)) + start;
+
+				for (int i = 0; i < numSamples; ++i)
+					output[i] = laneData[i * channelsPerGroup + lane];
+			}
+		}
+	}
+}
+
+void MultiChannelBiquadEngine::processGroup(int group, int numSamples)
+{
+	auto* data = interleaved.data() + group * maxBlockSize;
+	auto& groupState1 = state1[group];
+	auto& groupState2 = state2[group];
+	const auto& groupSections = group == 0 ? firstGroupSections : sections;
+
+	for (int index = 0; index < numSections; ++index)
+	{
+		const auto& section = groupSections[index];
+		const auto slot = sectionSlots[index];
+
+		auto s1 = groupState1[slot];
+		auto s2 = groupState2[slot];
+
+		//transposed direct form II
+		for (int i = 0; i < numSamples; ++i)
+		{
+			auto x = data[i];
+			auto y = section.b0 * x + s1;
+
+			s1 = section.b1 * x - section.a1 * y + s2;
+			s2 = section.b2 * x - section.a2 * y;
+
+			data[i] = y;
+		}
+
+		groupState1[slot] = s1;
+		groupState2[slot] = s2;
+	}
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    MultiChannelBiquadEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientSet.h"
+
+//Runs the compiled biquad cascade for any number of channels, packing groups of channels
+//into the lanes of a SIMD register so one pass filters a whole group. All channels share
+//one coefficient set; coefficients and state live in flat arrays indexed by section
+//instead of behind per filter CoefficientsPtr objects. Bands routed to one of the first
+//two channels only differ in the lanes of the first group.
+class MultiChannelBiquadEngine
+{
+public:
+	using Register = juce::dsp::SIMDRegister<float>;
+
+	static constexpr int channelsPerGroup = (int)Register::SIMDNumElements;
+	static constexpr int maxSections = CompiledCascade::maxSections;
+
+	//channels 0 and 1 have to share the first group for per channel routing
+	static_assert(channelsPerGroup >= 2, "SIMD registers need at least two float lanes");
+
+	void prepare(const juce::dsp::ProcessSpec& spec);
+	void reset();
+
+	//Audio thread safe, only copies and broadcasts the compiled cascade
+	void setCoefficients(const CoefficientSet& coefficientSet);
+
+	//Audio thread: swaps the first section of one band in place, for dynamic peak bands
+	void setBandSection(int band, const BiquadCoefficients& coefficients);
+
+	void process(const juce::dsp::AudioBlock<float>& block);
+
+private:
+	struct Section
+	{
+		Register b0, b1, b2, a1, a2;
+	};
+
+	using SectionState = std::array<Register, maxSections>;
+
+	void loadSection(int index, const BiquadCoefficients& source);
+	void processGroup(int group, int numSamples);
+
+	//packed active sections, each pointing at the state of the slot it was compiled from.
+	//The first group has its own copy with per lane coefficients; the rest only run sections
+	//set to both channels, the others are identity there.
+	std::array<Section, maxSections> sections;
+	std::array<Section, maxSections> firstGroupSections;
+	std::array<BandChannels, maxSections> sectionChannels{};
+	std::array<int, maxSections> sectionSlots{};
+	int numSections = 0;
+	//packed index of each band's first section, -1 when it was compiled out
+	std::array<int, ChainSettings::numBands> bandSectionIndices{};
+
+	//per channel group
+	std::vector<SectionState> state1, state2;
+	std::vector<Register> interleaved;
+
+	int numGroups = 0;
+	int maxBlockSize = 0;
+};
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    ParameterHandles.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include "ChainSettings.h"
+
+//Every parameter the engine reads, looked up by ID once at construction. Building a ChainSettings
+//snapshot is then a handful of relaxed atomic loads, with no string building, hashing or
+//allocation, so it is safe from the audio thread as well as the message and designer threads.
+class ParameterHandles
+{
+public:
+	struct Handle
+	{
+		std::atomic<float>* value = nullptr;
+		juce::RangedAudioParameter* parameter = nullptr;
+
+		float load() const { return value->load(std::memory_order_relaxed); }
+	};
+
+	struct BandHandles
+	{
+		Handle freq, gain, slope, type;
+		Handle dynamic, threshold, ratio, attack, release, sidechain;
+		Handle channels;
+	};
+
+	explicit ParameterHandles(juce::AudioProcessorValueTreeState& apvts)
+	{
+		for (int i = 0; i < ChainSettings::numBands; ++i)
+		{
+			auto& band = bands[(size_t)i];
+			band.freq = find(apvts, getParameterId(i + 1, "freq"));
+			band.gain = find(apvts, getParameterId(i + 1, "gain"));
+			band.slope = find(apvts, getParameterId(i + 1, "slope"));
+			band.type = find(apvts, getParameterId(i + 1, "type"));
+			band.dynamic = find(apvts, getParameterId(i + 1, "dynamic"));
+			band.threshold = find(apvts, getParameterId(i + 1, "threshold"));
+			band.ratio = find(apvts, getParameterId(i + 1, "ratio"));
+			band.attack = find(apvts, getParameterId(i + 1, "attack"));
+			band.release = find(apvts, getParameterId(i + 1, "release"));
+			band.sidechain = find(apvts, getParameterId(i + 1, "sidechain"));
+			band.channels = find(apvts, getParameterId(i + 1, "channels"));
+		}
+
+		filterMode = find(apvts, "filter_mode");
+		oversampling = find(apvts, "oversampling");
+		oversamplingQuality = find(apvts, "oversampling_quality");
+		stereoMode = find(apvts, "stereo_mode");
+	}
+
+	const BandHandles& getBand(int bandIndex) const { return bands[(size_t)bandIndex]; }
+
+	ChainSettings getChainSettings() const
+	{
+		ChainSettings settings;
+
+		for (int i = 0; i < ChainSettings::numBands; ++i)
+		{
+			const auto& band = bands[(size_t)i];
+			settings.bandSettings[i].band_freq = band.freq.load();
+			settings.bandSettings[i].band_gain = band.gain.load();
+			settings.bandSettings[i].band_slope = static_cast<Slope>(band.slope.load());
+			settings.bandSettings[i].band_type = static_cast<BandType>(band.type.load());
+			settings.bandSettings[i].band_dynamic = band.dynamic.load() >= 0.5f;
+			settings.bandSettings[i].band_threshold = band.threshold.load();
+			settings.bandSettings[i].band_ratio = band.ratio.load();
+			settings.bandSettings[i].band_attack = band.attack.load();
+			settings.bandSettings[i].band_release = band.release.load();
+			settings.bandSettings[i].band_sidechain = band.sidechain.load() >= 0.5f;
+			settings.bandSettings[i].band_channels = static_cast<BandChannels>(band.channels.load());
+		}
+
+		settings.filterMode = static_cast<FilterMode>(filterMode.load());
+		settings.oversamplingOrder = static_cast<int>(oversampling.load());
+		settings.oversamplingQuality = static_cast<OversamplingQuality>(oversamplingQuality.load());
+		settings.stereoMode = static_cast<StereoMode>(stereoMode.load());
+
+		return settings;
+	}
+
+private:
+	static Handle find(juce::AudioProcessorValueTreeState& apvts, const juce::String& parameterId)
+	{
+		Handle handle{ apvts.getRawParameterValue(parameterId), apvts.getParameter(parameterId) };
+
+		//every ID here comes from createParameterLayout, so a miss is a typo
+		jassert(handle.value != nullptr && handle.parameter != nullptr);
+		return handle;
+	}
+
+	std::array<BandHandles, ChainSettings::numBands> bands;
+	Handle filterMode, oversampling, oversamplingQuality, stereoMode;
+
+	JUCE_DECLARE_NON_COPYABLE(ParameterHandles)
+};
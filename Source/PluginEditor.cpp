@@ -9,46 +9,76 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-juce::Colour* getColourScheme()
+juce::Colour getBandColour(int bandIndex)
 {
-	juce::Colour colourScheme[3] = {
+	static const juce::Colour colourScheme[] = {
 		juce::Colours::purple,
 		juce::Colours::pink,
 		juce::Colours::orange
 	};
 
-	return colourScheme;
+	constexpr int numColours = (int)(sizeof(colourScheme) / sizeof(colourScheme[0]));
+
+	//builds with more bands than colours go round the scheme again, a little brighter each time
+	return colourScheme[bandIndex % numColours].brighter(0.3f * (float)(bandIndex / numColours));
 }
 
 //==============================================================================
 ParametricEQ2AudioProcessorEditor::ParametricEQ2AudioProcessorEditor(ParametricEQ2AudioProcessor& p)
 	: AudioProcessorEditor(&p), audioProcessor(p),
 	responseCurveComponent(audioProcessor),
-	band1GainVerticalSliderAttachment(audioProcessor.apvts, "band1_gain", band1GainVerticalSlider),
-	band2GainVerticalSliderAttachment(audioProcessor.apvts, "band2_gain", band2GainVerticalSlider),
-	band3GainVerticalSliderAttachment(audioProcessor.apvts, "band3_gain", band3GainVerticalSlider),
-
-	band1FreqRotarySliderAttachment(audioProcessor.apvts, "band1_freq", band1FreqRotarySlider),
-	band2FreqRotarySliderAttachment(audioProcessor.apvts, "band2_freq", band2FreqRotarySlider),
-	band3FreqRotarySliderAttachment(audioProcessor.apvts, "band3_freq", band3FreqRotarySlider),
-
-	band1SlopeChoiceSliderAttachment(audioProcessor.apvts, "band1_slope", band1SlopeChoiceSlider),
-	band2SlopeChoiceSliderAttachment(audioProcessor.apvts, "band2_slope", band2SlopeChoiceSlider),
-	band3SlopeChoiceSliderAttachment(audioProcessor.apvts, "band3_slope", band3SlopeChoiceSlider),
-
-	band1TypeChoiceSliderAttachment(audioProcessor.apvts, "band1_type", band1TypeChoiceSlider),
-	band2TypeChoiceSliderAttachment(audioProcessor.apvts, "band2_type", band2TypeChoiceSlider),
-	band3TypeChoiceSliderAttachment(audioProcessor.apvts, "band3_type", band3TypeChoiceSlider)
+	gainVerticalSliderAttachments(makeAttachments("gain", gainVerticalSliders)),
+	freqRotarySliderAttachments(makeAttachments("freq", freqRotarySliders)),
+	slopeChoiceSliderAttachments(makeAttachments("slope", slopeChoiceSliders)),
+	typeChoiceSliderAttachments(makeAttachments("type", typeChoiceSliders)),
+	dynamicButtonAttachments(makeAttachments<ButtonAttachment>("dynamic", dynamicButtons)),
+	sidechainButtonAttachments(makeAttachments<ButtonAttachment>("sidechain", sidechainButtons)),
+	thresholdRotarySliderAttachments(makeAttachments("threshold", thresholdRotarySliders)),
+	ratioRotarySliderAttachments(makeAttachments("ratio", ratioRotarySliders)),
+	attackRotarySliderAttachments(makeAttachments("attack", attackRotarySliders)),
+	releaseRotarySliderAttachments(makeAttachments("release", releaseRotarySliders)),
+	filterModeAttachment(attachChoices("filter_mode", filterModeBox)),
+	oversamplingAttachment(attachChoices("oversampling", oversamplingBox)),
+	oversamplingQualityAttachment(attachChoices("oversampling_quality", oversamplingQualityBox)),
+	stereoModeAttachment(attachChoices("stereo_mode", stereoModeBox)),
+	channelBoxAttachments(makeBandArray<ComboBoxAttachment>([this](int bandIndex)
+		{
+			return attachChoices(getParameterId(bandIndex + 1, "channels"), channelBoxes[(size_t)bandIndex]);
+		})),
+	snapshotAttachment(*audioProcessor.apvts.getParameter("snapshot"), [this](float) { updateSnapshotButtons(); })
 {
 	// Make sure that before the constructor has finished, you've set the
 	// editor's size to whatever you need it to be.
 
+	for (int slot = 0; slot < SnapshotBank::numSlots; ++slot)
+	{
+		snapshotButtons[(size_t)slot].setButtonText(SnapshotBank::getSlotName(slot));
+		snapshotButtons[(size_t)slot].onClick = [this, slot] { snapshotClicked(slot); };
+	}
+
+	storeSnapshotButton.setClickingTogglesState(true);
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		dynamicButtons[(size_t)i].setButtonText("Dynamic");
+		dynamicButtons[(size_t)i].setColour(juce::ToggleButton::tickColourId, getBandColour(i));
+		sidechainButtons[(size_t)i].setButtonText("Sidechain");
+
+		thresholdRotarySliders[(size_t)i].setTooltip("Threshold");
+		ratioRotarySliders[(size_t)i].setTooltip("Ratio");
+		attackRotarySliders[(size_t)i].setTooltip("Attack");
+		releaseRotarySliders[(size_t)i].setTooltip("Release");
+	}
+
+	snapshotAttachment.sendInitialUpdate();
+
 	for (auto* component : getComponents())
 	{
 		addAndMakeVisible(component);
 	}
 
-	setSize(600, 300);
+	//the parameter column keeps the 3 band build's slider width as bands are added
+	setSize(400 + 200 * ChainSettings::numBands / 3, 300 + bandControlsHeight + controlRowHeight);
 }
 
 ParametricEQ2AudioProcessorEditor::~ParametricEQ2AudioProcessorEditor()
@@ -68,65 +98,146 @@ void ParametricEQ2AudioProcessorEditor::resized()
 	// This is generally where you'll want to lay out the positions of any
 	auto bounds = getLocalBounds();
 
+	//global controls run along the bottom, under the curve and the band sliders
+	auto controlRow = bounds.removeFromBottom(controlRowHeight).reduced(4, 3);
+
+	storeSnapshotButton.setBounds(controlRow.removeFromRight(50));
+	for (int slot = SnapshotBank::numSlots - 1; slot >= 0; --slot)
+		snapshotButtons[(size_t)slot].setBounds(controlRow.removeFromRight(28));
+
+	filterModeBox.setBounds(controlRow.removeFromLeft(120));
+	controlRow.removeFromLeft(4);
+	oversamplingBox.setBounds(controlRow.removeFromLeft(60));
+	controlRow.removeFromLeft(4);
+	oversamplingQualityBox.setBounds(controlRow.removeFromLeft(110));
+	controlRow.removeFromLeft(4);
+	stereoModeBox.setBounds(controlRow.removeFromLeft(100));
+
+	layOutBandControls(bounds.removeFromBottom(bandControlsHeight));
+
 	auto paramsArea = bounds.removeFromRight(bounds.getWidth() * 0.33);
 	auto responseArea = bounds.reduced(10);
 
 	auto bottomParamsArea = paramsArea.removeFromBottom(paramsArea.getHeight() * 0.2);
 	auto topParamsArea = paramsArea.removeFromTop(paramsArea.getHeight() * 0.2);
 
-	band1GainVerticalSlider.setBounds(paramsArea.removeFromLeft(paramsArea.getWidth() * 0.33));
-	band2GainVerticalSlider.setBounds(paramsArea.removeFromLeft(paramsArea.getWidth() * 0.5));
-	band3GainVerticalSlider.setBounds(paramsArea.removeFromLeft(paramsArea.getWidth()));
+	layOutBandSliders(gainVerticalSliders, paramsArea);
 
 	auto bottomParamsFreqArea = bottomParamsArea.removeFromTop(bottomParamsArea.getHeight() * 0.5);
 	auto bottomParamsBandWidthArea = bottomParamsArea;
 
-	band1FreqRotarySlider.setBounds(bottomParamsFreqArea.removeFromLeft(bottomParamsFreqArea.getWidth() * 0.33));
-	band2FreqRotarySlider.setBounds(bottomParamsFreqArea.removeFromLeft(bottomParamsFreqArea.getWidth() * 0.5));
-	band3FreqRotarySlider.setBounds(bottomParamsFreqArea.removeFromLeft(bottomParamsFreqArea.getWidth()));
-
-	band1BandWidthRotarySlider.setBounds(bottomParamsBandWidthArea.removeFromLeft(bottomParamsBandWidthArea.getWidth() * 0.33));
-	band2BandWidthRotarySlider.setBounds(bottomParamsBandWidthArea.removeFromLeft(bottomParamsBandWidthArea.getWidth() * 0.5));
-	band3BandWidthRotarySlider.setBounds(bottomParamsBandWidthArea.removeFromLeft(bottomParamsBandWidthArea.getWidth()));
+	layOutBandSliders(freqRotarySliders, bottomParamsFreqArea);
+	layOutBandSliders(bandWidthRotarySliders, bottomParamsBandWidthArea);
 
 	auto topParamsTypeArea = topParamsArea.removeFromTop(topParamsArea.getHeight() * 0.5);
 	auto topParamsSlopeArea = topParamsArea;
 
-	band1TypeChoiceSlider.setBounds(topParamsTypeArea.removeFromLeft(topParamsTypeArea.getWidth() * 0.33));
-	band2TypeChoiceSlider.setBounds(topParamsTypeArea.removeFromLeft(topParamsTypeArea.getWidth() * 0.5));
-	band3TypeChoiceSlider.setBounds(topParamsTypeArea.removeFromLeft(topParamsTypeArea.getWidth()));
-
-	band1SlopeChoiceSlider.setBounds(topParamsSlopeArea.removeFromLeft(topParamsSlopeArea.getWidth() * 0.33));
-	band2SlopeChoiceSlider.setBounds(topParamsSlopeArea.removeFromLeft(topParamsSlopeArea.getWidth() * 0.5));
-	band3SlopeChoiceSlider.setBounds(topParamsSlopeArea.removeFromLeft(topParamsSlopeArea.getWidth()));
+	layOutBandSliders(typeChoiceSliders, topParamsTypeArea);
+	layOutBandSliders(slopeChoiceSliders, topParamsSlopeArea);
 
 	responseCurveComponent.setBounds(responseArea);
 }
 
 std::vector<juce::Component*> ParametricEQ2AudioProcessorEditor::getComponents()
 {
-	return
+	std::vector<juce::Component*> components;
+
+	auto addSliders = [&components](auto& sliders)
+		{
+			for (auto& slider : sliders)
+				components.push_back(&slider);
+		};
+
+	addSliders(gainVerticalSliders);
+	addSliders(freqRotarySliders);
+	addSliders(bandWidthRotarySliders);
+	addSliders(slopeChoiceSliders);
+	addSliders(typeChoiceSliders);
+
+	addSliders(dynamicButtons);
+	addSliders(sidechainButtons);
+	addSliders(thresholdRotarySliders);
+	addSliders(ratioRotarySliders);
+	addSliders(attackRotarySliders);
+	addSliders(releaseRotarySliders);
+	addSliders(channelBoxes);
+
+	components.push_back(&responseCurveComponent);
+
+	components.push_back(&filterModeBox);
+	components.push_back(&oversamplingBox);
+	components.push_back(&oversamplingQualityBox);
+	components.push_back(&stereoModeBox);
+
+	for (auto& button : snapshotButtons)
+		components.push_back(&button);
+
+	components.push_back(&storeSnapshotButton);
+
+	return components;
+}
+
+void ParametricEQ2AudioProcessorEditor::layOutBandControls(juce::Rectangle<int> area)
+{
+	//one column per band across the whole width: its buttons, its routing, then its knobs
+	for (int i = 0; i < ChainSettings::numBands; ++i)
 	{
-		&band1GainVerticalSlider,
-		&band2GainVerticalSlider,
-		&band3GainVerticalSlider,
+		const auto band = (size_t)i;
+		auto column = area.removeFromLeft(area.getWidth() / (ChainSettings::numBands - i)).reduced(4, 2);
 
-		&band1FreqRotarySlider,
-		&band2FreqRotarySlider,
-		&band3FreqRotarySlider,
+		auto buttonRow = column.removeFromTop(24);
+		dynamicButtons[band].setBounds(buttonRow.removeFromLeft(buttonRow.getWidth() / 2));
+		sidechainButtons[band].setBounds(buttonRow);
 
-		&band1BandWidthRotarySlider,
-		&band2BandWidthRotarySlider,
-		&band3BandWidthRotarySlider,
+		channelBoxes[band].setBounds(column.removeFromTop(24).reduced(0, 2));
 
-		&band1SlopeChoiceSlider,
-		&band2SlopeChoiceSlider,
-		&band3SlopeChoiceSlider,
+		const auto knobWidth = column.getWidth() / 4;
+		thresholdRotarySliders[band].setBounds(column.removeFromLeft(knobWidth));
+		ratioRotarySliders[band].setBounds(column.removeFromLeft(knobWidth));
+		attackRotarySliders[band].setBounds(column.removeFromLeft(knobWidth));
+		releaseRotarySliders[band].setBounds(column);
+	}
+}
 
-		&band1TypeChoiceSlider,
-		&band2TypeChoiceSlider,
-		&band3TypeChoiceSlider,
+ParametricEQ2AudioProcessorEditor::ComboBoxAttachment ParametricEQ2AudioProcessorEditor::attachChoices(
+	const juce::String& parameterId, juce::ComboBox& box)
+{
+	if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(audioProcessor.apvts.getParameter(parameterId)))
+		box.addItemList(choice->choices, 1);
 
-		&responseCurveComponent
-	};
-}
\ No newline at end of file
+	return ComboBoxAttachment(audioProcessor.apvts, parameterId, box);
+}
+
+void ParametricEQ2AudioProcessorEditor::snapshotClicked(int slot)
+{
+	if (storeSnapshotButton.getToggleState())
+	{
+		audioProcessor.storeSnapshot(slot);
+		storeSnapshotButton.setToggleState(false, juce::dontSendNotification);
+	}
+	else if (slot == juce::roundToInt(audioProcessor.apvts.getRawParameterValue("snapshot")->load()))
+	{
+		//the parameter wouldn't move, so nothing would reach the processor
+		audioProcessor.recallSnapshot(slot);
+	}
+	else
+	{
+		//the processor recalls it when the parameter arrives, as it would from host automation
+		snapshotAttachment.setValueAsCompleteGesture((float)slot);
+	}
+
+	updateSnapshotButtons();
+}
+
+void ParametricEQ2AudioProcessorEditor::updateSnapshotButtons()
+{
+	const auto selectedSlot = juce::roundToInt(audioProcessor.apvts.getRawParameterValue("snapshot")->load());
+
+	for (int slot = 0; slot < SnapshotBank::numSlots; ++slot)
+	{
+		auto& button = snapshotButtons[(size_t)slot];
+		button.setToggleState(slot == selectedSlot, juce::dontSendNotification);
+		//empty slots stay clickable, storing is how they fill
+		button.setAlpha(audioProcessor.hasSnapshot(slot) ? 1.0f : 0.5f);
+	}
+}
@@ -48,24 +48,7 @@ struct CustomChoiceSlider : juce::Slider
 	}
 };
 
-template<typename BandType>
-double getBandMagnitudeForFrequency(BandType& band, double freq, double sampleRate)
-{
-	double magnitude = 1.f;
-
-	if (!band.isBypassed<0>())
-		{magnitude *= band.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);}
-	if (!band.isBypassed<1>())
-		magnitude *= band.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-	if (!band.isBypassed<2>())
-		magnitude *= band.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-	if (!band.isBypassed<3>())
-		magnitude *= band.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-
-	return magnitude;
-}
-
-juce::Colour* getColourScheme();
+juce::Colour getBandColour(int bandIndex);
 
 //==============================================================================
 /**
@@ -85,26 +68,105 @@ private:
 	// access the processor object that created it.
 	ParametricEQ2AudioProcessor& audioProcessor;
 
-	CustomVerticalSlider band1GainVerticalSlider, band2GainVerticalSlider, band3GainVerticalSlider;
+	template<typename SliderType>
+	using BandSliders = std::array<SliderType, ChainSettings::numBands>;
+
+	BandSliders<CustomVerticalSlider> gainVerticalSliders;
+
+	BandSliders<CustomRotarySlider> freqRotarySliders;
+	BandSliders<CustomRotarySlider> bandWidthRotarySliders;
+
+	BandSliders<CustomChoiceSlider> slopeChoiceSliders;
+	BandSliders<CustomChoiceSlider> typeChoiceSliders;
 
-	CustomRotarySlider band1FreqRotarySlider, band2FreqRotarySlider, band3FreqRotarySlider;
-	CustomRotarySlider band1BandWidthRotarySlider, band2BandWidthRotarySlider, band3BandWidthRotarySlider;
+	//dynamics and routing, in a strip of band columns above the bottom row
+	using BandButtons = std::array<juce::ToggleButton, ChainSettings::numBands>;
 
-	CustomChoiceSlider band1SlopeChoiceSlider, band2SlopeChoiceSlider, band3SlopeChoiceSlider;
-	CustomChoiceSlider band1TypeChoiceSlider, band2TypeChoiceSlider, band3TypeChoiceSlider;
+	BandButtons dynamicButtons;
+	BandButtons sidechainButtons;
+
+	BandSliders<CustomRotarySlider> thresholdRotarySliders;
+	BandSliders<CustomRotarySlider> ratioRotarySliders;
+	BandSliders<CustomRotarySlider> attackRotarySliders;
+	BandSliders<CustomRotarySlider> releaseRotarySliders;
+
+	BandSliders<juce::ComboBox> channelBoxes;
+
+	//names the unlabelled dynamics knobs
+	juce::TooltipWindow tooltipWindow{ this };
 
 	ResponseCurveComponent responseCurveComponent;
 
 	using APVTS = juce::AudioProcessorValueTreeState;
 	using Attachment = APVTS::SliderAttachment;
+	using BandAttachments = std::array<Attachment, ChainSettings::numBands>;
+
+	BandAttachments gainVerticalSliderAttachments;
+	BandAttachments freqRotarySliderAttachments;
+
+	BandAttachments slopeChoiceSliderAttachments;
+	BandAttachments typeChoiceSliderAttachments;
+
+	using ButtonAttachment = APVTS::ButtonAttachment;
+
+	std::array<ButtonAttachment, ChainSettings::numBands> dynamicButtonAttachments;
+	std::array<ButtonAttachment, ChainSettings::numBands> sidechainButtonAttachments;
 
-	Attachment band1GainVerticalSliderAttachment, band2GainVerticalSliderAttachment, band3GainVerticalSliderAttachment;
-	Attachment band1FreqRotarySliderAttachment, band2FreqRotarySliderAttachment, band3FreqRotarySliderAttachment;
+	BandAttachments thresholdRotarySliderAttachments;
+	BandAttachments ratioRotarySliderAttachments;
+	BandAttachments attackRotarySliderAttachments;
+	BandAttachments releaseRotarySliderAttachments;
 
-	Attachment band1SlopeChoiceSliderAttachment, band2SlopeChoiceSliderAttachment, band3SlopeChoiceSliderAttachment;
-	Attachment band1TypeChoiceSliderAttachment, band2TypeChoiceSliderAttachment, band3TypeChoiceSliderAttachment;
+	//global choices, along the bottom row
+	juce::ComboBox filterModeBox;
+	juce::ComboBox oversamplingBox;
+	juce::ComboBox oversamplingQualityBox;
+	juce::ComboBox stereoModeBox;
+
+	using ComboBoxAttachment = APVTS::ComboBoxAttachment;
+
+	ComboBoxAttachment filterModeAttachment;
+	ComboBoxAttachment oversamplingAttachment;
+	ComboBoxAttachment oversamplingQualityAttachment;
+	ComboBoxAttachment stereoModeAttachment;
+
+	std::array<ComboBoxAttachment, ChainSettings::numBands> channelBoxAttachments;
+
+	//Fills the box with the parameter's choices first, the attachment selects items by index
+	ComboBoxAttachment attachChoices(const juce::String& parameterId, juce::ComboBox& box);
+
+	//A / B / C / D recall their snapshot by moving its parameter; with Store down, the next slot
+	//clicked takes the current settings instead
+	std::array<juce::TextButton, SnapshotBank::numSlots> snapshotButtons;
+	juce::TextButton storeSnapshotButton{ "Store" };
+	juce::ParameterAttachment snapshotAttachment;
+
+	void snapshotClicked(int slot);
+	void updateSnapshotButtons();
+
+	static constexpr int controlRowHeight = 30;
+	static constexpr int bandControlsHeight = 124;
+
+	template<typename AttachmentType = Attachment, typename ComponentType>
+	std::array<AttachmentType, ChainSettings::numBands> makeAttachments(const juce::String& bandParameter, BandSliders<ComponentType>& components)
+	{
+		return makeBandArray<AttachmentType>([&](int bandIndex)
+			{
+				return AttachmentType(audioProcessor.apvts, getParameterId(bandIndex + 1, bandParameter), components[(size_t)bandIndex]);
+			});
+	}
 
 	std::vector<juce::Component*> getComponents();
 
+	void layOutBandControls(juce::Rectangle<int> area);
+
+	//Splits the area into one equal column per band
+	template<typename SliderType>
+	static void layOutBandSliders(BandSliders<SliderType>& sliders, juce::Rectangle<int> area)
+	{
+		for (int i = 0; i < ChainSettings::numBands; ++i)
+			sliders[(size_t)i].setBounds(area.removeFromLeft(area.getWidth() / (ChainSettings::numBands - i)));
+	}
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParametricEQ2AudioProcessorEditor)
 };
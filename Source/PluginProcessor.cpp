@@ -8,6 +8,10 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeAudit.h"
+#include "SpectrumAnalyzer.h"
+#include "MidSideMatrix.h"
+#include "BinaryState.h"
 
 //==============================================================================
 ParametricEQ2AudioProcessor::ParametricEQ2AudioProcessor()
@@ -16,16 +20,27 @@ ParametricEQ2AudioProcessor::ParametricEQ2AudioProcessor()
 #if ! JucePlugin_IsMidiEffect
 #if ! JucePlugin_IsSynth
 		.withInput("Input", juce::AudioChannelSet::stereo(), true)
+		.withInput("Sidechain", juce::AudioChannelSet::stereo(), false)
 #endif
 		.withOutput("Output", juce::AudioChannelSet::stereo(), true)
 #endif
 	)
 #endif
 {
+	coefficientDesigner.onSetPublished = [this](const CoefficientSet& coefficientSet)
+		{
+			if (coefficientSet.chainSettings.filterMode == FilterMode::LinearPhase)
+				linearPhaseEngine.updateKernel(coefficientSet);
+		};
+
+	apvts.addParameterListener("snapshot", this);
+	startTimer(messageThreadPollIntervalMs);
 }
 
 ParametricEQ2AudioProcessor::~ParametricEQ2AudioProcessor()
 {
+	stopTimer();
+	apvts.removeParameterListener("snapshot", this);
 }
 
 //==============================================================================
@@ -95,27 +110,52 @@ void ParametricEQ2AudioProcessor::prepareToPlay(double sampleRate, int samplesPe
 {
 	juce::dsp::ProcessSpec spec;
 
-	spec.maximumBlockSize = samplesPerBlock;
+	spec.maximumBlockSize = samplesPerBlock * maxOversamplingFactor;
 
-	spec.numChannels = 1;
+	spec.numChannels = getTotalNumOutputChannels();
 
 	spec.sampleRate = sampleRate;
 
-	leftChain.prepare(spec);
-	rightChain.prepare(spec);
+	filterEngine.prepare(spec);
+	svfEngine.prepare(spec);
 
-	auto chainSettings = getChainSettings(apvts);
+	auto baseRateSpec = spec;
+	baseRateSpec.maximumBlockSize = samplesPerBlock;
+	linearPhaseEngine.prepare(baseRateSpec);
+	dynamicsEngine.prepare(baseRateSpec);
 
-	updateFilters();
+	//every factor/quality combination is built up front so switching never allocates
+	oversamplers.clear();
+	for (int order = 1; order <= maxOversamplingOrder; ++order)
+	{
+		for (auto filterType : { juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+								 juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple })
+		{
+			auto oversampler = std::make_unique<juce::dsp::Oversampling<float>>(spec.numChannels, order, filterType, true, true);
+			oversampler->initProcessing((size_t)samplesPerBlock);
+			oversamplers.push_back(std::move(oversampler));
+		}
+	}
+
+	activeOversampler = nullptr;
+	activeSettings = {};
+	activeGeneration = 0;
+	awaitingKernel = false;
 
-	leftChannelFifo.prepare(samplesPerBlock);
-	rightChannelFifo.prepare(samplesPerBlock);
+	coefficientDesigner.prepare(sampleRate);
+
+	//the host wants a figure before the first block; the audio thread corrects it if the
+	//engine it ends up running differs
+	setLatencySamples(getLatencySamplesFor(parameters.getChainSettings()));
+	activeLatencySamples.store(getLatencySamples());
+	latencyDirty.store(false);
 }
 
 void ParametricEQ2AudioProcessor::releaseResources()
 {
 	// When playback stops, you can use this as an opportunity to free up any
 	// spare memory, etc.
+	coefficientDesigner.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -125,12 +165,10 @@ bool ParametricEQ2AudioProcessor::isBusesLayoutSupported(const BusesLayout& layo
 	juce::ignoreUnused(layouts);
 	return true;
 #else
-	// This is the place where you check if the layout is supported.
-	// In this template code we only support mono or stereo.
-	// Some plugin hosts, such as certain GarageBand versions, will only
-	// load plugins that support stereo bus layouts.
-	if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-		&& layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+	// Any layout works, from mono to surround and ambisonic beds: every channel
+	// runs through the same coefficient set. The sidechain, if any, is mixed to
+	// mono for the dynamic bands' detectors, so it may have any layout too.
+	if (layouts.getMainOutputChannelSet().isDisabled())
 		return false;
 
 	// This checks if the input layout matches the output layout
@@ -146,6 +184,7 @@ bool ParametricEQ2AudioProcessor::isBusesLayoutSupported(const BusesLayout& layo
 
 void ParametricEQ2AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+	RealtimeAudit::ScopedAudioThread realtimeAudit;
 	juce::ScopedNoDenormals noDenormals;
 	auto totalNumInputChannels = getTotalNumInputChannels();
 	auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -159,22 +198,117 @@ void ParametricEQ2AudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
 	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
 		buffer.clear(i, 0, buffer.getNumSamples());
 
-	auto chainSettings = getChainSettings(apvts);
+	if (isNonRealtime())
+		coefficientDesigner.designIfNeeded();
+
+	//a recalled snapshot arrives already designed; designer sets from before the recall describe
+	//the settings it replaced and are dropped
+	if (auto* recalledSet = snapshots.acquire())
+	{
+		applyCoefficientSet(*recalledSet);
+		minimumGeneration = recalledSet->generation;
+	}
+
+	if (auto* coefficientSet = coefficientDesigner.acquire())
+	{
+		if (coefficientSet->generation >= minimumGeneration)
+			applyCoefficientSet(*coefficientSet);
+	}
+
+	if (awaitingKernel)
+		finishLinearPhaseSwitch(buffer.getNumSamples());
 
-	updateFilters();
+	//a kernel held back behind the one that just landed; the redesign brings the latest settings
+	if (linearPhaseEngine.takeDeferredRequest())
+		coefficientDesigner.requestUpdateWithoutWaking();
 
-	juce::dsp::AudioBlock<float> block(buffer);
-	auto leftBlock = block.getSingleChannelBlock(0);
-	auto rightBlock = block.getSingleChannelBlock(1);
+	//bus buffers only refer to the host's channels, a disabled sidechain just has none
+	auto mainBuffer = getBusBuffer(buffer, false, 0);
+	auto sidechainBuffer = getBusBuffer(buffer, true, 1);
 
-	juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-	juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+	//the analyzer only ever costs the audio thread a few memcpys, everything else happens on its own
+	//thread; with no editor open or while rendering offline it costs nothing at all
+	analyzerRingInUse.store(true);
+	auto* ring = isNonRealtime() ? nullptr : activeAnalyzerRing.load();
 
-	leftChain.process(leftContext);
-	rightChain.process(rightContext);
+	const auto feedAnalyzer = ring != nullptr && ring->beginWrite(buffer.getNumSamples());
+
+	//only a block that writes to the ring holds it, so detaching never waits out a block that doesn't
+	if (!feedAnalyzer)
+		analyzerRingInUse.store(false);
+	if (feedAnalyzer)
+		writeAnalyzerChannels(*ring, mainBuffer, AnalyzerChannel::PreLeft, AnalyzerChannel::PreRight);
+
+	juce::dsp::AudioBlock<float> block(mainBuffer);
+	juce::dsp::AudioBlock<float> sidechainBlock(sidechainBuffer);
+
+	//encoded once at the host rate, so every engine and the oversampler just see two channels
+	const auto midSide = activeSettings.stereoMode == StereoMode::MidSide;
+	if (midSide)
+		MidSideMatrix::encode(block);
+
+	if (activeSettings.filterMode == FilterMode::LinearPhase)
+	{
+		//the kernel is sampled from filters designed at the oversampled rate, so it is already free of cramping;
+		//it is fixed, so dynamic bands sit at their static gain
+		linearPhaseEngine.process(block);
+	}
+	else if (activeOversampler != nullptr)
+	{
+		auto oversampledBlock = activeOversampler->processSamplesUp(block);
+		processFilters(oversampledBlock, block, sidechainBlock);
+		activeOversampler->processSamplesDown(block);
+	}
+	else
+	{
+		processFilters(block, block, sidechainBlock);
+	}
 
-	leftChannelFifo.update(buffer);
-	leftChannelFifo.update(buffer);
+	if (midSide)
+		MidSideMatrix::decode(block);
+
+	if (feedAnalyzer)
+	{
+		writeAnalyzerChannels(*ring, mainBuffer, AnalyzerChannel::PostLeft, AnalyzerChannel::PostRight);
+		ring->finishWrite(buffer.getNumSamples());
+		analyzerRingInUse.store(false);
+	}
+}
+
+void ParametricEQ2AudioProcessor::writeAnalyzerChannels(SampleRing& ring, const juce::AudioBuffer<float>& buffer, int leftChannel, int rightChannel)
+{
+	const auto numChannels = buffer.getNumChannels();
+	const auto numSamples = buffer.getNumSamples();
+
+	if (numChannels == 0)
+		return;
+
+	//mono layouts show up as identical left and right, wider ones as their first two channels
+	ring.writeChannel(leftChannel, buffer.getReadPointer(0), numSamples);
+	ring.writeChannel(rightChannel, buffer.getReadPointer(juce::jmin(1, numChannels - 1)), numSamples);
+}
+
+SampleRing& ParametricEQ2AudioProcessor::attachAnalyzerRing()
+{
+	jassert(analyzerRing == nullptr); //one analyzer at a time
+
+	//room for a few hundred milliseconds at any rate, far more than the analyzer thread ever lags behind
+	analyzerRing = std::make_unique<SampleRing>();
+	analyzerRing->prepare(numAnalyzerChannels, juce::jmax(getBlockSize() * 4, 1 << 16));
+
+	activeAnalyzerRing.store(analyzerRing.get());
+	return *analyzerRing;
+}
+
+void ParametricEQ2AudioProcessor::detachAnalyzerRing()
+{
+	activeAnalyzerRing.store(nullptr);
+
+	//a block that picked up the ring before it was cleared may still be writing to it
+	while (analyzerRingInUse.load())
+		juce::Thread::yield();
+
+	analyzerRing.reset();
 }
 
 //==============================================================================
@@ -195,120 +329,245 @@ void ParametricEQ2AudioProcessor::getStateInformation(juce::MemoryBlock& destDat
 	// You should use this method to store your parameters in the memory block.
 	// You could do that either as raw data, or use the XML or ValueTree classes
 	// as intermediaries to make it easy to save and load complex data.
-	juce::MemoryOutputStream mos(destData, true);
-	apvts.state.writeToStream(mos);
+	BinaryState::write(apvts, destData);
 }
 
 void ParametricEQ2AudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
 	// You should use this method to restore your parameters from this memory block,
 	// whose contents will have been created by the getStateInformation() call.
+	if (BinaryState::isBinaryState(data, sizeInBytes))
+	{
+		//a truncated state is left alone rather than half applied
+		if (BinaryState::read(apvts, data, sizeInBytes))
+		{
+			//the restored snapshot parameter only names the slot, the restored values win
+			pendingSnapshotRecall.store(-1);
+			coefficientDesigner.requestUpdate();
+		}
+		return;
+	}
+
+	//sessions saved before the binary format hold the whole ValueTree
 	auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
 	if (tree.isValid())
 	{
 		apvts.replaceState(tree);
-		updateFilters();
+		pendingSnapshotRecall.store(-1);
+		coefficientDesigner.requestUpdate();
 	}
 }
 
-void ParametricEQ2AudioProcessor::updateFilters()
+bool ParametricEQ2AudioProcessor::isReadyToRender() const
+{
+	if (awaitingKernel)
+		return false;
+
+	return activeSettings.filterMode != FilterMode::LinearPhase || linearPhaseEngine.isKernelLoaded(activeGeneration);
+}
+
+void ParametricEQ2AudioProcessor::applyCoefficientSet(const CoefficientSet& coefficientSet)
 {
-	auto chainSettings = getChainSettings(apvts);
+	auto newSettings = coefficientSet.chainSettings;
+
+	filterEngine.setCoefficients(coefficientSet);
+	svfEngine.setTargets(newSettings);
+	dynamicsEngine.setDesign(coefficientSet);
+
+	//linear phase only takes over once the convolutions run this set's kernel. Until then the
+	//engine that was running carries on with the new coefficients, and the host keeps its latency.
+	awaitingKernel = newSettings.filterMode == FilterMode::LinearPhase
+		&& activeSettings.filterMode != FilterMode::LinearPhase
+		&& !linearPhaseEngine.isKernelLoaded(coefficientSet.generation);
+
+	if (awaitingKernel)
+		newSettings.filterMode = activeSettings.filterMode;
+
+	//the set was designed for one specific rate, so the processing rate switches together with it;
+	//a new stereo mode changes what the filter state holds, so that starts over as well
+	if (newSettings.oversamplingOrder != activeSettings.oversamplingOrder
+		|| newSettings.oversamplingQuality != activeSettings.oversamplingQuality
+		|| newSettings.filterMode != activeSettings.filterMode
+		|| newSettings.stereoMode != activeSettings.stereoMode)
+	{
+		activeOversampler = getOversampler(newSettings);
 
-	updateBand<0>(chainSettings, leftChain, getSampleRate());
-	updateBand<0>(chainSettings, rightChain, getSampleRate());
+		if (activeOversampler != nullptr)
+			activeOversampler->reset();
 
-	updateBand<1>(chainSettings, leftChain, getSampleRate());
-	updateBand<1>(chainSettings, rightChain, getSampleRate());
+		svfEngine.setSampleRate(coefficientSet.sampleRate);
+		filterEngine.reset();
+		svfEngine.reset();
+		linearPhaseEngine.reset();
+		dynamicsEngine.reset();
+	}
 
-	updateBand<2>(chainSettings, leftChain, getSampleRate());
-	updateBand<2>(chainSettings, rightChain, getSampleRate());
+	activeSettings = newSettings;
+	activeGeneration = coefficientSet.generation;
+
+	updateActiveLatency();
 }
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacement)
+void ParametricEQ2AudioProcessor::finishLinearPhaseSwitch(int numSamples)
 {
-	*old = *replacement;
+	if (!linearPhaseEngine.isKernelLoaded(activeGeneration))
+	{
+		linearPhaseEngine.processSilence(numSamples);
+		return;
+	}
+
+	awaitingKernel = false;
+	activeSettings.filterMode = FilterMode::LinearPhase;
+
+	//drops what the convolutions held from the silence, or from the last time they ran
+	linearPhaseEngine.reset();
+	updateActiveLatency();
 }
 
-juce::String getParameterId(int bandNumber, juce::String bandParameter)
+void ParametricEQ2AudioProcessor::updateActiveLatency()
 {
-	juce::String str;
-	return str << "band" << bandNumber << "_" << bandParameter;
+	//two atomic stores, so applying a set never posts a message or takes a lock
+	const auto latency = getLatencySamplesFor(activeSettings);
+	if (latency != activeLatencySamples.load())
+	{
+		activeLatencySamples.store(latency);
+		latencyDirty.store(true);
+	}
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+void ParametricEQ2AudioProcessor::processFilters(const juce::dsp::AudioBlock<float>& block, const juce::dsp::AudioBlock<float>& detectorInput,
+	const juce::dsp::AudioBlock<float>& sidechain)
 {
-	ChainSettings settings;
+	if (!dynamicsEngine.isActive())
+	{
+		runFilterEngine(block);
+		return;
+	}
 
-	for (int i = 0; i < sizeof(settings.bandSettings) / sizeof(settings.bandSettings[0]); ++i) {
-		settings.bandSettings[i].band_freq = apvts.getRawParameterValue(getParameterId(i + 1, "freq"))->load();
-		settings.bandSettings[i].band_gain = apvts.getRawParameterValue(getParameterId(i + 1, "gain"))->load();
-		settings.bandSettings[i].band_slope = static_cast<Slope>(apvts.getRawParameterValue(getParameterId(i + 1, "slope"))->load());
-		settings.bandSettings[i].band_type = static_cast<BandType>(apvts.getRawParameterValue(getParameterId(i + 1, "type"))->load());
+	const auto numSamples = (int)detectorInput.getNumSamples();
+	const auto factor = (int)block.getNumSamples() / juce::jmax(numSamples, 1);
+	const auto hasSidechain = sidechain.getNumChannels() > 0 && sidechain.getNumSamples() >= (size_t)numSamples;
+
+	//each sub block is analysed before it is filtered, which matters when detectorInput is the block itself
+	for (int start = 0; start < numSamples; start += DynamicsEngine::subBlockSize)
+	{
+		const auto subBlockSize = juce::jmin(DynamicsEngine::subBlockSize, numSamples - start);
+
+		dynamicsEngine.analyse(detectorInput.getSubBlock((size_t)start, (size_t)subBlockSize),
+			hasSidechain ? sidechain.getSubBlock((size_t)start, (size_t)subBlockSize) : juce::dsp::AudioBlock<float>());
+		applyDynamicGains();
+
+		runFilterEngine(block.getSubBlock((size_t)(start * factor), (size_t)(subBlockSize * factor)));
 	}
+}
 
-	return settings;
+void ParametricEQ2AudioProcessor::runFilterEngine(const juce::dsp::AudioBlock<float>& block)
+{
+	if (activeSettings.filterMode == FilterMode::SmoothSvf)
+		svfEngine.process(block);
+	else
+		filterEngine.process(block);
 }
 
-juce::AudioProcessorValueTreeState::ParameterLayout ParametricEQ2AudioProcessor::createParameterLayout()
+void ParametricEQ2AudioProcessor::applyDynamicGains()
 {
-	juce::AudioProcessorValueTreeState::ParameterLayout layout;
+	const auto useSvf = activeSettings.filterMode == FilterMode::SmoothSvf;
 
-	//Band Frequencies
-	layout.add(
-		std::make_unique<juce::AudioParameterFloat>(
-			"band1_freq",
-			"Band 1 Freq",
-			juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
-			20.f
-		)
-	);
+	for (int band = 0; band < ChainSettings::numBands; ++band)
+	{
+		float gainDb = 0.f;
+		if (!dynamicsEngine.takeGainChange(band, gainDb))
+			continue;
+
+		if (useSvf)
+			svfEngine.setDynamicGain(band, gainDb);
+		else
+			filterEngine.setBandSection(band, makeDynamicPeakSection(dynamicsEngine.getDesign(band), gainDb));
+	}
+}
 
-	layout.add(
-		std::make_unique<juce::AudioParameterFloat>(
-			"band2_freq",
-			"Band 2 Freq",
-			juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
-			1000.f
-		)
-	);
+juce::dsp::Oversampling<float>* ParametricEQ2AudioProcessor::getOversampler(const ChainSettings& chainSettings) const
+{
+	if (chainSettings.oversamplingOrder <= 0)
+		return nullptr;
 
-	layout.add(
-		std::make_unique<juce::AudioParameterFloat>(
-			"band3_freq",
-			"Band 3 Freq",
-			juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
-			20000.f
-		)
-	);
+	auto index = (chainSettings.oversamplingOrder - 1) * 2 + (int)chainSettings.oversamplingQuality;
+	return juce::isPositiveAndBelow(index, (int)oversamplers.size()) ? oversamplers[(size_t)index].get() : nullptr;
+}
 
-	//Band gains
-	layout.add(
-		std::make_unique<juce::AudioParameterFloat>(
-			"band1_gain",
-			"Band 1 Gain",
-			juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-			0.f
-		)
-	);
+int ParametricEQ2AudioProcessor::getLatencySamplesFor(const ChainSettings& chainSettings) const
+{
+	if (chainSettings.filterMode == FilterMode::LinearPhase)
+		return linearPhaseEngine.getLatencySamples();
 
-	layout.add(
-		std::make_unique<juce::AudioParameterFloat>(
-			"band2_gain",
-			"Band 2 Gain",
-			juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-			0.f
-		)
-	);
+	if (auto* oversampler = getOversampler(chainSettings))
+		return juce::roundToInt(oversampler->getLatencyInSamples());
 
-	layout.add(
-		std::make_unique<juce::AudioParameterFloat>(
-			"band3_gain",
-			"Band 3 Gain",
-			juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-			0.f
-		)
-	);
+	return 0;
+}
+
+void ParametricEQ2AudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+	//host automation calls this from the audio thread, and a recall sets parameters and designs,
+	//so it only leaves the slot for the timer
+	if (parameterID == "snapshot")
+		pendingSnapshotRecall.store(juce::roundToInt(newValue));
+}
+
+void ParametricEQ2AudioProcessor::timerCallback()
+{
+	//the latency follows the engine that is actually running, which trails the parameters by
+	//at least one design and, for linear phase, until the kernel has loaded
+	if (latencyDirty.exchange(false))
+		setLatencySamples(activeLatencySamples.load());
+
+	const auto snapshotSlot = pendingSnapshotRecall.exchange(-1);
+	if (snapshotSlot >= 0)
+		snapshots.recall(snapshotSlot);
+}
+
+juce::String getParameterId(int bandNumber, juce::String bandParameter)
+{
+	juce::String str;
+	return str << "band" << bandNumber << "_" << bandParameter;
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout ParametricEQ2AudioProcessor::createParameterLayout()
+{
+	juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+	//Parameters are grouped by kind rather than by band, which keeps the 3 band build's parameter order
+	auto getBandName = [](int bandIndex, const juce::String& parameterName)
+		{
+			juce::String str;
+			return str << "Band " << (bandIndex + 1) << " " << parameterName;
+		};
+
+	//Band Frequencies
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		layout.add(
+			std::make_unique<juce::AudioParameterFloat>(
+				getParameterId(i + 1, "freq"),
+				getBandName(i, "Freq"),
+				juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
+				getDefaultBandFrequency(i)
+			)
+		);
+	}
+
+	//Band gains
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		layout.add(
+			std::make_unique<juce::AudioParameterFloat>(
+				getParameterId(i + 1, "gain"),
+				getBandName(i, "Gain"),
+				juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+				0.f
+			)
+		);
+	}
 
 	//Band Types
 	juce::StringArray bandTypes;
@@ -316,65 +575,180 @@ juce::AudioProcessorValueTreeState::ParameterLayout ParametricEQ2AudioProcessor:
 	bandTypes.add("Band Pass");
 	bandTypes.add("High Pass");
 
-	layout.add(
-		std::make_unique<juce::AudioParameterChoice>(
-			"band1_type",
-			"Band 1 Type",
-			bandTypes,
-			1
-		)
-	);
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		layout.add(
+			std::make_unique<juce::AudioParameterChoice>(
+				getParameterId(i + 1, "type"),
+				getBandName(i, "Type"),
+				bandTypes,
+				1
+			)
+		);
+	}
+
+	//Band slopes
+	juce::StringArray bandSlopes;
+	for (int i = 0; i < 4; ++i) {
+		juce::String str;
+		str << (12 + i * 12);
+		str << " db/Oct";
+		bandSlopes.add(str);
+	}
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		layout.add(
+			std::make_unique<juce::AudioParameterChoice>(
+				getParameterId(i + 1, "slope"),
+				getBandName(i, "Slope"),
+				bandSlopes,
+				0
+			)
+		);
+	}
+
+	//Filter mode
+	juce::StringArray filterModes;
+	filterModes.add("Biquad");
+	filterModes.add("Smooth (SVF)");
+	filterModes.add("Linear Phase");
 
 	layout.add(
 		std::make_unique<juce::AudioParameterChoice>(
-			"band2_type",
-			"Band 2 Type",
-			bandTypes,
-			1
+			"filter_mode",
+			"Filter Mode",
+			filterModes,
+			0
 		)
 	);
 
+	//Oversampling
+	juce::StringArray oversamplingFactors;
+	oversamplingFactors.add("Off");
+	oversamplingFactors.add("2x");
+	oversamplingFactors.add("4x");
+
 	layout.add(
 		std::make_unique<juce::AudioParameterChoice>(
-			"band3_type",
-			"Band 3 Type",
-			bandTypes,
-			1
+			"oversampling",
+			"Oversampling",
+			oversamplingFactors,
+			0
 		)
 	);
 
-	//Band slopes
-	juce::StringArray bandSlopes;
-	for (int i = 0; i < 4; ++i) {
-		juce::String str;
-		str << (12 + i * 12);
-		str << " db/Oct";
-		bandSlopes.add(str);
-	}
+	juce::StringArray oversamplingQualities;
+	oversamplingQualities.add("Polyphase IIR");
+	oversamplingQualities.add("Equiripple FIR");
 
 	layout.add(
 		std::make_unique<juce::AudioParameterChoice>(
-			"band1_slope",
-			"Band 1 Slope",
-			bandSlopes,
+			"oversampling_quality",
+			"Oversampling Quality",
+			oversamplingQualities,
 			0
 		)
 	);
 
+	//Band dynamics, added last so existing automation indices don't move
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		layout.add(
+			std::make_unique<juce::AudioParameterBool>(
+				getParameterId(i + 1, "dynamic"),
+				getBandName(i, "Dynamic"),
+				false
+			)
+		);
+
+		layout.add(
+			std::make_unique<juce::AudioParameterFloat>(
+				getParameterId(i + 1, "threshold"),
+				getBandName(i, "Threshold"),
+				juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f),
+				-24.f
+			)
+		);
+
+		layout.add(
+			std::make_unique<juce::AudioParameterFloat>(
+				getParameterId(i + 1, "ratio"),
+				getBandName(i, "Ratio"),
+				juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.4f),
+				2.f
+			)
+		);
+
+		layout.add(
+			std::make_unique<juce::AudioParameterFloat>(
+				getParameterId(i + 1, "attack"),
+				getBandName(i, "Attack"),
+				juce::NormalisableRange<float>(0.1f, 200.f, 0.1f, 0.3f),
+				10.f
+			)
+		);
+
+		layout.add(
+			std::make_unique<juce::AudioParameterFloat>(
+				getParameterId(i + 1, "release"),
+				getBandName(i, "Release"),
+				juce::NormalisableRange<float>(5.f, 2000.f, 1.f, 0.3f),
+				150.f
+			)
+		);
+
+		layout.add(
+			std::make_unique<juce::AudioParameterBool>(
+				getParameterId(i + 1, "sidechain"),
+				getBandName(i, "Sidechain"),
+				false
+			)
+		);
+	}
+
+	//Stereo
+	juce::StringArray bandChannels;
+	bandChannels.add("Both");
+	bandChannels.add("Left / Mid");
+	bandChannels.add("Right / Side");
+
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		layout.add(
+			std::make_unique<juce::AudioParameterChoice>(
+				getParameterId(i + 1, "channels"),
+				getBandName(i, "Channels"),
+				bandChannels,
+				0
+			)
+		);
+	}
+
+	juce::StringArray stereoModes;
+	stereoModes.add("Linked");
+	stereoModes.add("Left / Right");
+	stereoModes.add("Mid / Side");
+
 	layout.add(
 		std::make_unique<juce::AudioParameterChoice>(
-			"band2_slope",
-			"Band 2 Slope",
-			bandSlopes,
+			"stereo_mode",
+			"Stereo Mode",
+			stereoModes,
 			0
 		)
 	);
 
+	//picks the A / B / C / D snapshot to recall, so hosts can automate the switch
+	juce::StringArray snapshotSlots;
+	for (int slot = 0; slot < SnapshotBank::numSlots; ++slot)
+		snapshotSlots.add(SnapshotBank::getSlotName(slot));
+
 	layout.add(
 		std::make_unique<juce::AudioParameterChoice>(
-			"band3_slope",
-			"Band 3 Slope",
-			bandSlopes,
+			"snapshot",
+			"Snapshot",
+			snapshotSlots,
 			0
 		)
 	);
@@ -0,0 +1,445 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeAudit.h"
+
+#if PARAMETRICEQ2_RT_AUDIT
+
+#include <new>
+#include <cerrno>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <execinfo.h>
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <unistd.h>
+ #include <time.h>
+#endif
+
+namespace RealtimeAudit
+{
+	//Fixed size log: the audio thread claims a slot with one fetch_add and marks it complete,
+	//so recording never allocates or locks itself
+	static constexpr int logCapacity = 512;
+
+	struct LogEntry
+	{
+		Violation violation;
+		std::atomic<bool> complete{ false };
+	};
+
+	static LogEntry logEntries[logCapacity];
+	static std::atomic<int> numClaimed{ 0 };
+	static std::atomic<int> numDropped{ 0 };
+	static std::atomic<bool> enabled{ false };
+
+	//Plain thread_locals: the audit runs in an executable, where these live in static TLS and
+	//reading them never goes back into malloc
+	static thread_local int audioThreadDepth = 0;
+	static thread_local bool isRecording = false;
+
+	static void record(ViolationKind kind, const char* function)
+	{
+		if (audioThreadDepth == 0 || isRecording || !enabled.load(std::memory_order_relaxed))
+			return;
+
+		isRecording = true;
+
+		auto index = numClaimed.fetch_add(1, std::memory_order_relaxed);
+
+		if (index < logCapacity)
+		{
+			auto& entry = logEntries[index];
+			entry.violation.kind = kind;
+			entry.violation.function = function;
+#if JUCE_LINUX || JUCE_MAC
+			entry.violation.numFrames = backtrace(entry.violation.frames, Violation::maxFrames);
+#else
+			entry.violation.numFrames = 0;
+#endif
+			entry.complete.store(true, std::memory_order_release);
+		}
+		else
+		{
+			numDropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		isRecording = false;
+	}
+
+	void setEnabled(bool shouldBeEnabled)
+	{
+#if JUCE_LINUX || JUCE_MAC
+		//the first backtrace loads the unwinder, which must not happen inside an audited block
+		void* warmUp[2];
+		backtrace(warmUp, 2);
+#endif
+		enabled.store(shouldBeEnabled);
+	}
+
+	bool isEnabled() { return enabled.load(); }
+
+	int getNumViolations()
+	{
+		auto count = juce::jmin(numClaimed.load(std::memory_order_acquire), logCapacity);
+
+		//a slot that was claimed but not yet completed ends the readable part of the log
+		for (int i = 0; i < count; ++i)
+			if (!logEntries[i].complete.load(std::memory_order_acquire))
+				return i;
+
+		return count;
+	}
+
+	int getNumDropped() { return numDropped.load(); }
+
+	const Violation& getViolation(int index)
+	{
+		jassert(juce::isPositiveAndBelow(index, getNumViolations()));
+		return logEntries[index].violation;
+	}
+
+	void clear()
+	{
+		for (auto& entry : logEntries)
+			entry.complete.store(false);
+
+		numClaimed.store(0);
+		numDropped.store(0);
+	}
+
+	ScopedAudioThread::ScopedAudioThread() { ++audioThreadDepth; }
+	ScopedAudioThread::~ScopedAudioThread() { --audioThreadDepth; }
+}
+
+//==============================================================================
+//Heap interception. Every platform gets the global operator new/delete in all their plain,
+//nothrow and aligned forms; Linux also catches malloc and friends directly through glibc's
+//__libc_* entry points.
+#if JUCE_LINUX
+extern "C"
+{
+	void* __libc_malloc(size_t);
+	void* __libc_calloc(size_t, size_t);
+	void* __libc_realloc(void*, size_t);
+	void* __libc_memalign(size_t, size_t);
+	void* __libc_valloc(size_t);
+	void __libc_free(void*);
+}
+
+//operator new goes straight to glibc so one allocation is not logged twice
+static void* allocateUnaudited(std::size_t size) { return __libc_malloc(size); }
+static void* allocateAlignedUnaudited(std::size_t size, std::size_t alignment) { return __libc_memalign(alignment, size); }
+static void freeUnaudited(void* memory) { __libc_free(memory); }
+static void freeAlignedUnaudited(void* memory) { __libc_free(memory); }
+#elif JUCE_WINDOWS
+static void* allocateUnaudited(std::size_t size) { return std::malloc(size); }
+static void* allocateAlignedUnaudited(std::size_t size, std::size_t alignment) { return _aligned_malloc(size, alignment); }
+static void freeUnaudited(void* memory) { std::free(memory); }
+static void freeAlignedUnaudited(void* memory) { _aligned_free(memory); }
+#else
+static void* allocateUnaudited(std::size_t size) { return std::malloc(size); }
+
+static void* allocateAlignedUnaudited(std::size_t size, std::size_t alignment)
+{
+	void* memory = nullptr;
+	return posix_memalign(&memory, juce::jmax(alignment, sizeof(void*)), size) == 0 ? memory : nullptr;
+}
+
+static void freeUnaudited(void* memory) { std::free(memory); }
+static void freeAlignedUnaudited(void* memory) { std::free(memory); }
+#endif
+
+void* operator new(std::size_t size)
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "operator new");
+
+	if (auto* memory = allocateUnaudited(size == 0 ? 1 : size))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "operator new[]");
+
+	if (auto* memory = allocateUnaudited(size == 0 ? 1 : size))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (memory != nullptr)
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Deallocation, "operator delete");
+
+	freeUnaudited(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	if (memory != nullptr)
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Deallocation, "operator delete[]");
+
+	freeUnaudited(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept { operator delete(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { operator delete[](memory); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "operator new");
+	return allocateUnaudited(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "operator new[]");
+	return allocateUnaudited(size == 0 ? 1 : size);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept { operator delete(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { operator delete[](memory); }
+
+#if __cpp_aligned_new
+//over-aligned types, SIMDRegister containers among them, come through these instead
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "aligned operator new");
+
+	if (auto* memory = allocateAlignedUnaudited(size == 0 ? 1 : size, (std::size_t)alignment))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "aligned operator new[]");
+
+	if (auto* memory = allocateAlignedUnaudited(size == 0 ? 1 : size, (std::size_t)alignment))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "aligned operator new");
+	return allocateAlignedUnaudited(size == 0 ? 1 : size, (std::size_t)alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "aligned operator new[]");
+	return allocateAlignedUnaudited(size == 0 ? 1 : size, (std::size_t)alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+	if (memory != nullptr)
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Deallocation, "aligned operator delete");
+
+	freeAlignedUnaudited(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+	if (memory != nullptr)
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Deallocation, "aligned operator delete[]");
+
+	freeAlignedUnaudited(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept { operator delete(memory, alignment); }
+void operator delete[](void* memory, std::size_t, std::align_val_t alignment) noexcept { operator delete[](memory, alignment); }
+void operator delete(void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept { operator delete(memory, alignment); }
+void operator delete[](void* memory, std::align_val_t alignment, const std::nothrow_t&) noexcept { operator delete[](memory, alignment); }
+#endif
+
+#if JUCE_LINUX
+extern "C"
+{
+	void* malloc(size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "malloc");
+		return __libc_malloc(size);
+	}
+
+	void* calloc(size_t count, size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "calloc");
+		return __libc_calloc(count, size);
+	}
+
+	void* realloc(void* memory, size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "realloc");
+		return __libc_realloc(memory, size);
+	}
+
+	int posix_memalign(void** result, size_t alignment, size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "posix_memalign");
+		*result = __libc_memalign(alignment, size);
+		return *result != nullptr ? 0 : ENOMEM;
+	}
+
+	void* aligned_alloc(size_t alignment, size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "aligned_alloc");
+		return __libc_memalign(alignment, size);
+	}
+
+	void* memalign(size_t alignment, size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "memalign");
+		return __libc_memalign(alignment, size);
+	}
+
+	void* valloc(size_t size)
+	{
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Allocation, "valloc");
+		return __libc_valloc(size);
+	}
+
+	void free(void* memory)
+	{
+		if (memory != nullptr)
+			RealtimeAudit::record(RealtimeAudit::ViolationKind::Deallocation, "free");
+
+		__libc_free(memory);
+	}
+}
+#endif
+
+//==============================================================================
+//Locks and syscalls that can block, forwarded to the next definition in the link order.
+//juce::CriticalSection, WaitableEvent and the message queue all end up in these.
+#if JUCE_LINUX || JUCE_MAC
+template<typename FunctionType>
+static FunctionType getNextSymbol(FunctionType& cached, const char* name)
+{
+	if (cached == nullptr)
+		cached = reinterpret_cast<FunctionType>(dlsym(RTLD_NEXT, name));
+
+	return cached;
+}
+
+extern "C"
+{
+	int pthread_mutex_lock(pthread_mutex_t* mutex)
+	{
+		static int (*next)(pthread_mutex_t*) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Lock, "pthread_mutex_lock");
+		return getNextSymbol(next, "pthread_mutex_lock")(mutex);
+	}
+
+	int pthread_mutex_trylock(pthread_mutex_t* mutex)
+	{
+		static int (*next)(pthread_mutex_t*) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Lock, "pthread_mutex_trylock");
+		return getNextSymbol(next, "pthread_mutex_trylock")(mutex);
+	}
+
+	int pthread_cond_wait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+	{
+		static int (*next)(pthread_cond_t*, pthread_mutex_t*) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Lock, "pthread_cond_wait");
+		return getNextSymbol(next, "pthread_cond_wait")(condition, mutex);
+	}
+
+	int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+	{
+		static int (*next)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Lock, "pthread_cond_timedwait");
+		return getNextSymbol(next, "pthread_cond_timedwait")(condition, mutex, time);
+	}
+
+	int nanosleep(const struct timespec* duration, struct timespec* remaining)
+	{
+		static int (*next)(const struct timespec*, struct timespec*) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Syscall, "nanosleep");
+		return getNextSymbol(next, "nanosleep")(duration, remaining);
+	}
+
+	ssize_t write(int fd, const void* data, size_t size)
+	{
+		static ssize_t (*next)(int, const void*, size_t) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Syscall, "write");
+		return getNextSymbol(next, "write")(fd, data, size);
+	}
+
+	ssize_t read(int fd, void* data, size_t size)
+	{
+		static ssize_t (*next)(int, void*, size_t) = nullptr;
+		RealtimeAudit::record(RealtimeAudit::ViolationKind::Syscall, "read");
+		return getNextSymbol(next, "read")(fd, data, size);
+	}
+}
+#endif
+
+//==============================================================================
+juce::String RealtimeAudit::getKindName(ViolationKind kind)
+{
+	switch (kind)
+	{
+	case ViolationKind::Allocation: return "allocation";
+	case ViolationKind::Deallocation: return "deallocation";
+	case ViolationKind::Lock: return "lock";
+	case ViolationKind::Syscall: return "syscall";
+	}
+
+	return {};
+}
+
+juce::StringArray RealtimeAudit::getSymbolisedStack(const Violation& violation)
+{
+	juce::StringArray stack;
+
+#if JUCE_LINUX || JUCE_MAC
+	if (auto** symbols = backtrace_symbols(violation.frames, violation.numFrames))
+	{
+		//the first two frames are record() and the interceptor itself
+		for (int i = 2; i < violation.numFrames; ++i)
+			stack.add(symbols[i]);
+
+		free(symbols);
+	}
+#else
+	juce::ignoreUnused(violation);
+#endif
+
+	return stack;
+}
+
+#else
+
+namespace RealtimeAudit
+{
+	void setEnabled(bool) {}
+	bool isEnabled() { return false; }
+	int getNumViolations() { return 0; }
+	int getNumDropped() { return 0; }
+
+	const Violation& getViolation(int)
+	{
+		static Violation none;
+		jassertfalse;
+		return none;
+	}
+
+	void clear() {}
+	juce::String getKindName(ViolationKind) { return {}; }
+	juce::StringArray getSymbolisedStack(const Violation&) { return {}; }
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//Build with PARAMETRICEQ2_RT_AUDIT=1 (the RealtimeAudit console target does) to intercept
+//heap allocation, mutex locks and blocking syscalls made while the audio thread is inside
+//processBlock. Plugin builds leave it off and every hook below compiles to nothing.
+#ifndef PARAMETRICEQ2_RT_AUDIT
+ #define PARAMETRICEQ2_RT_AUDIT 0
+#endif
+
+namespace RealtimeAudit
+{
+	enum class ViolationKind
+	{
+		Allocation,
+		Deallocation,
+		Lock,
+		Syscall
+	};
+
+	struct Violation
+	{
+		static constexpr int maxFrames = 24;
+
+		ViolationKind kind = ViolationKind::Allocation;
+		const char* function = "";
+		void* frames[maxFrames] = {};
+		int numFrames = 0;
+	};
+
+	//Nothing is recorded until enabled, so preparing and pre-rolling stay out of the log
+	void setEnabled(bool shouldBeEnabled);
+	bool isEnabled();
+
+	//Log readers, for the thread driving the audit while no block is being processed
+	int getNumViolations();
+	int getNumDropped();
+	const Violation& getViolation(int index);
+	void clear();
+
+	juce::String getKindName(ViolationKind kind);
+	juce::StringArray getSymbolisedStack(const Violation& violation);
+
+	//Marks the current thread as the audio thread for its lifetime, put at the top of processBlock
+	struct ScopedAudioThread
+	{
+#if PARAMETRICEQ2_RT_AUDIT
+		ScopedAudioThread();
+		~ScopedAudioThread();
+#else
+		ScopedAudioThread() {}
+#endif
+	};
+}
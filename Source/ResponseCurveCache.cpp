@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    ResponseCurveCache.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurveCache.h"
+
+void ResponseCurveCache::prepare(int numPoints, double designSampleRate, double hostSampleRate, double minFreq, double maxFreq)
+{
+	const auto size = (size_t)juce::jmax(0, numPoints);
+
+	for (auto* table : { &cos1, &sin1, &cos2, &sin2, &totalDb, &real, &imaginary, &numerator, &denominator })
+		table->assign(size, 0.0);
+
+	for (auto& band : bandDb)
+		band.assign(size, 0.0);
+
+	for (size_t i = 0; i < size; ++i)
+	{
+		auto freq = juce::jmin(juce::mapToLog10((double)i / (double)size, minFreq, maxFreq), hostSampleRate / 2.0);
+		auto w = juce::MathConstants<double>::twoPi * freq / designSampleRate;
+
+		cos1[i] = std::cos(w);
+		sin1[i] = std::sin(w);
+		cos2[i] = std::cos(2.0 * w);
+		sin2[i] = std::sin(2.0 * w);
+	}
+
+	preparedSampleRate = designSampleRate;
+	preparedHostSampleRate = hostSampleRate;
+	totalIsValid = false;
+}
+
+void ResponseCurveCache::updateBand(int bandIndex, const BandCoefficients& band)
+{
+	using FVO = juce::FloatVectorOperations;
+
+	const auto numPoints = (int)cos1.size();
+	std::fill(numerator.begin(), numerator.end(), 1.0);
+	std::fill(denominator.begin(), denominator.end(), 1.0);
+
+	//|b0 + b1 e^-jw + b2 e^-2jw|^2 and the same for 1, a1, a2, multiplied up over the sections
+	auto multiplyBySquaredMagnitude = [&](std::vector<double>& product, double c0, double c1, double c2)
+		{
+			FVO::copyWithMultiply(real.data(), cos1.data(), c1, numPoints);
+			FVO::addWithMultiply(real.data(), cos2.data(), c2, numPoints);
+			FVO::add(real.data(), c0, numPoints);
+
+			FVO::copyWithMultiply(imaginary.data(), sin1.data(), c1, numPoints);
+			FVO::addWithMultiply(imaginary.data(), sin2.data(), c2, numPoints);
+
+			FVO::multiply(real.data(), real.data(), numPoints);
+			FVO::addWithMultiply(real.data(), imaginary.data(), imaginary.data(), numPoints);
+			FVO::multiply(product.data(), real.data(), numPoints);
+		};
+
+	for (int s = 0; s < band.numSections; ++s)
+	{
+		const auto& section = band.sections[(size_t)s];
+		multiplyBySquaredMagnitude(numerator, section.b0, section.b1, section.b2);
+		multiplyBySquaredMagnitude(denominator, 1.0, section.a1, section.a2);
+	}
+
+	auto& db = bandDb[(size_t)bandIndex];
+	for (int i = 0; i < numPoints; ++i)
+		db[(size_t)i] = 10.0 * std::log10(juce::jmax(numerator[(size_t)i] / denominator[(size_t)i], 1.0e-20));
+
+	totalIsValid = false;
+}
+
+const std::vector<double>& ResponseCurveCache::getTotalDb()
+{
+	if (!totalIsValid)
+	{
+		std::fill(totalDb.begin(), totalDb.end(), 0.0);
+
+		for (auto& band : bandDb)
+			juce::FloatVectorOperations::add(totalDb.data(), band.data(), (int)totalDb.size());
+
+		totalIsValid = true;
+	}
+
+	return totalDb;
+}
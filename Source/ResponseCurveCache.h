@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    ResponseCurveCache.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CoefficientSet.h"
+
+//Magnitude response of every band at a fixed set of log spaced frequencies.
+//The e^-jw and e^-2jw terms of each point are tabulated once per width and sample rate,
+//so re-evaluating a band is a handful of vector multiply-adds per section, and only bands
+//that actually changed get re-evaluated.
+class ResponseCurveCache
+{
+public:
+	bool needsPrepare(int numPoints, double designSampleRate, double hostSampleRate) const
+	{
+		return numPoints != (int)cos1.size() || designSampleRate != preparedSampleRate || hostSampleRate != preparedHostSampleRate;
+	}
+
+	//Rebuilds the tables, after which every band has to be updated again. The bands are designed
+	//at designSampleRate, the oversampled rate when oversampling is on; points past the host's
+	//Nyquist hold the value at Nyquist, since the audio never has anything up there.
+	void prepare(int numPoints, double designSampleRate, double hostSampleRate, double minFreq, double maxFreq);
+
+	void updateBand(int bandIndex, const BandCoefficients& band);
+
+	//Sum of all bands in dB, one value per point
+	const std::vector<double>& getTotalDb();
+
+private:
+	std::vector<double> cos1, sin1, cos2, sin2;
+	std::array<std::vector<double>, ChainSettings::numBands> bandDb;
+	std::vector<double> totalDb;
+	std::vector<double> real, imaginary, numerator, denominator;
+
+	double preparedSampleRate = 0.0;
+	double preparedHostSampleRate = 0.0;
+	bool totalIsValid = false;
+};
@@ -15,8 +15,8 @@
 
 //==============================================================================
 ResponseCurveComponent::ResponseCurveComponent(ParametricEQ2AudioProcessor& p) : audioProcessor(p),
-thumbs{ BandThumbComponent(p, 0), BandThumbComponent(p, 1), BandThumbComponent(p, 2) },
-leftChannelFifo(&audioProcessor.leftChannelFifo)
+thumbs(makeBandArray<BandThumbComponent>([&p](int bandIndex) { return BandThumbComponent(p, bandIndex); })),
+spectrumAnalyzer(audioProcessor.attachAnalyzerRing())
 {
     // In your constructor, you should add any child components, and
     // initialise any special settings that your component needs.
@@ -26,21 +26,23 @@ leftChannelFifo(&audioProcessor.leftChannelFifo)
         param->addListener(this);
     }
 
-    for (size_t i = 0; i < sizeof(thumbs) / sizeof(thumbs[0]); ++i) {
-        addAndMakeVisible(thumbs[i]);
+    for (auto& thumb : thumbs) {
+        addAndMakeVisible(thumb);
     }
 
     updateResponseCurve();
     updateThumbsFromParameters();
 
-    leftChannelFFTDataGenerator.changeOrder(FFTOrder::order8k);
-    monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+    applyAnalyzerOptions();
 
     startTimer(30);
 }
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    spectrumAnalyzer.stop();
+    audioProcessor.detachAnalyzerRing();
+
     const auto& params = audioProcessor.getParameters();
     for (auto param : params)
     {
@@ -52,24 +54,8 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
 {
     auto responseArea = getLocalBounds();
 
-    //FFT lines
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();
-
-    const auto binWidth = audioProcessor.getSampleRate() / (double)fftSize;
-
-    bool drawn = false;
-
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0) //Do we have more than 0 fft blocks available
-    {
-        std::vector<float> fftData; //Will contain fft data if we are able to pull a fft block
-
-        if (leftChannelFFTDataGenerator.getFFTData(fftData)) //Try to pull a fft block
-        {
-            if (!drawn)
-                drawFFTLines(g, fftData, fftSize, binWidth, -48.f);
-            drawn = true;
-        }
-    }
+    if (spectrumFrame != nullptr)
+        drawSpectrum(g, *spectrumFrame);
 
     drawResultingResponseCurve(g);
 
@@ -82,14 +68,15 @@ void ResponseCurveComponent::resized()
     // This method is where you should set the bounds of any child
     // components that your component contains..
     auto bounds = getLocalBounds();
+    responseCurveIsValid = false;
 
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
-    for (size_t i = 0; i < sizeof(thumbs) / sizeof(thumbs[0]); ++i) {
+    auto chainSettings = audioProcessor.parameters.getChainSettings();
+    for (size_t i = 0; i < thumbs.size(); ++i) {
         auto freq = chainSettings.bandSettings[i].band_freq;
         auto x = juce::mapFromLog10((double)freq, 20.0, 20000.0) * bounds.getWidth();
 
         thumbs[i].setBounds(x - thumbSize/2, bounds.getHeight() / 2 - thumbSize/2, thumbSize, thumbSize);
-        thumbs[i].setColour(getColourScheme()[i]);
+        thumbs[i].setColour(getBandColour((int)i));
     }
 }
 
@@ -100,24 +87,12 @@ void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float new
 
 void ResponseCurveComponent::timerCallback()
 {
-    juce::AudioBuffer<float> tempIncomingBuffer;
-
-    while (leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
-    {
-        if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer));
-        {
-            auto size = tempIncomingBuffer.getNumSamples();
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, 0),
-                monoBuffer.getReadPointer(0, size),
-                monoBuffer.getNumSamples() - size);
-
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size),
-                tempIncomingBuffer.getReadPointer(0, 0),
-                size);
+    if (analyzerSettings.sampleRate != audioProcessor.getSampleRate())
+        applyAnalyzerOptions();
 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
-        }
-    }
+    //the analyzer thread did all the work, just pick up its newest spectrum
+    if (auto* frame = spectrumAnalyzer.getLatestFrame())
+        spectrumFrame = frame;
 
     if (parametersChanged.compareAndSetBool(false, true))
     {
@@ -135,43 +110,45 @@ void ResponseCurveComponent::drawResultingResponseCurve(juce::Graphics& g)
 
     auto responseArea = getLocalBounds();
 
-    auto sampleRate = audioProcessor.getSampleRate();
-    auto width = responseArea.getWidth();
+    if (audioProcessor.getSampleRate() <= 0.0)
+        return;
 
-    std::vector<double> magnitudes;
-    magnitudes.resize(width);
+    const auto hostSampleRate = audioProcessor.getSampleRate();
+    const auto designSampleRate = hostSampleRate * audioProcessor.parameters.getChainSettings().getOversamplingFactor();
 
-    for (int i = 0; i < width; ++i) {
-        double magnitude = 1.f;
-
-        auto freq = mapToLog10(double(i) / double(width), 20.0, 20000.0);
+    if (responseCurveCache.needsPrepare(responseArea.getWidth(), designSampleRate, hostSampleRate))
+        updateResponseCurve();
 
-        magnitude *= getBandMagnitudeForFrequency(monoChain.get<0>(), freq, sampleRate);
-        magnitude *= getBandMagnitudeForFrequency(monoChain.get<1>(), freq, sampleRate);
-        magnitude *= getBandMagnitudeForFrequency(monoChain.get<2>(), freq, sampleRate);
+    if (!responseCurveIsValid)
+    {
+        const auto& magnitudes = responseCurveCache.getTotalDb();
 
-        magnitudes[i] = Decibels::gainToDecibels(magnitude);
-    }
+        const double outputMin = responseArea.getBottom();
+        const double outputMax = responseArea.getY();
+        auto map = [outputMin, outputMax](double input)
+            {
+                return jmap(input, -24.0, 24.0, outputMin, outputMax);
+            };
 
-    Path responseCurve;
+        responseCurve.clear();
 
-    const double outputMin = responseArea.getBottom();
-    const double outputMax = responseArea.getY();
-    auto map = [outputMin, outputMax](double input)
+        if (!magnitudes.empty())
         {
-            return jmap(input, -24.0, 24.0, outputMin, outputMax);
-        };
+            responseCurve.preallocateSpace(3 * ((int)magnitudes.size() + 3));
+            responseCurve.startNewSubPath(0, responseArea.getBottom());
+            responseCurve.lineTo(responseArea.getX(), map(magnitudes.front()));
 
-    responseCurve.startNewSubPath(0, responseArea.getBottom());
-    responseCurve.lineTo(responseArea.getX(), map(magnitudes.front()));
+            for (size_t i = 1; i < magnitudes.size(); ++i)
+            {
+                responseCurve.lineTo(responseArea.getX() + i, map(magnitudes[i]));
+            }
 
-    for (size_t i = 1; i < magnitudes.size(); ++i)
-    {
-        responseCurve.lineTo(responseArea.getX() + i, map(magnitudes[i]));
-    }
+            responseCurve.lineTo(responseArea.getRight(), responseArea.getBottom());
+            responseCurve.closeSubPath();
+        }
 
-    responseCurve.lineTo(responseArea.getRight(), responseArea.getBottom());
-    responseCurve.closeSubPath();
+        responseCurveIsValid = true;
+    }
 
     g.setColour(Colours::white);
     g.strokePath(responseCurve, PathStrokeType(2.f));
@@ -182,17 +159,40 @@ void ResponseCurveComponent::drawResultingResponseCurve(juce::Graphics& g)
 
 void ResponseCurveComponent::updateResponseCurve()
 {
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
-    updateBand<0>(chainSettings, monoChain, audioProcessor.getSampleRate());
-    updateBand<1>(chainSettings, monoChain, audioProcessor.getSampleRate());
-    updateBand<2>(chainSettings, monoChain, audioProcessor.getSampleRate());
+    //nothing to design against until the host has prepared the processor
+    if (audioProcessor.getSampleRate() <= 0.0)
+        return;
+
+    auto chainSettings = audioProcessor.parameters.getChainSettings();
+
+    //designed at the rate the filters actually run at, so oversampling shows up without BLT cramping
+    const auto hostSampleRate = audioProcessor.getSampleRate();
+    const auto designSampleRate = hostSampleRate * chainSettings.getOversamplingFactor();
+    const auto width = getLocalBounds().getWidth();
+
+    if (responseCurveCache.needsPrepare(width, designSampleRate, hostSampleRate))
+    {
+        responseCurveCache.prepare(width, designSampleRate, hostSampleRate, 20.0, 20000.0);
+        chainSettingsTracker.invalidate();
+    }
+
+    auto changedBands = chainSettingsTracker.update(chainSettings, designSampleRate);
+
+    for (int i = 0; i < ChainSettings::numBands; ++i)
+    {
+        if (changedBands & (1 << i))
+            responseCurveCache.updateBand(i, designBand(chainSettings.bandSettings[i], designSampleRate));
+    }
+
+    if (changedBands != 0)
+        responseCurveIsValid = false;
 }
 
 void ResponseCurveComponent::updateThumbsFromParameters()
 {
     using namespace juce;
 
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
+    auto chainSettings = audioProcessor.parameters.getChainSettings();
     auto responseArea = getLocalBounds();
     auto width = responseArea.getWidth();
 
@@ -203,7 +203,7 @@ void ResponseCurveComponent::updateThumbsFromParameters()
             return jmap(input, -24.0, 24.0, outputMin, outputMax);
         };
 
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < ChainSettings::numBands; ++i) {
         float freq = chainSettings.bandSettings[i].band_freq;
 
         auto x = mapFromLog10((double)freq, 20.0, 20000.0) * width;
@@ -213,55 +213,181 @@ void ResponseCurveComponent::updateThumbsFromParameters()
     }
 }
 
-void ResponseCurveComponent::drawFFTLines(juce::Graphics& g,
-    const std::vector<float>& renderData,
-    int fftSize,
-    float binWidth,
-    float negativeInfinity)
+juce::ValueTree ResponseCurveComponent::getAnalyzerOptions()
+{
+    return audioProcessor.apvts.state.getOrCreateChildWithName("Analyzer", nullptr);
+}
+
+void ResponseCurveComponent::applyAnalyzerOptions()
+{
+    auto options = getAnalyzerOptions();
+    auto previousSettings = analyzerSettings;
+
+    analyzerSettings.order = (FFTOrder)juce::jlimit((int)FFTOrder::order2k, (int)FFTOrder::order32k,
+        (int)options.getProperty("fftOrder", (int)FFTOrder::order8k));
+    analyzerSettings.overlap = juce::jlimit(1, 16, (int)options.getProperty("overlap", 4));
+    analyzerSettings.source = (AnalyzerSource)(int)options.getProperty("source", (int)AnalyzerSource::PrePost);
+    analyzerSettings.window = (AnalyzerWindow)(int)options.getProperty("window", (int)AnalyzerWindow::BlackmanHarris);
+    analyzerSettings.averagingMs = (float)options.getProperty("averagingMs", 0.f);
+    analyzerSettings.peakHold = (bool)options.getProperty("peakHold", false);
+    analyzerSettings.multirate = (bool)options.getProperty("multirate", false);
+    analyzerSettings.negativeInfinityDb = negativeInfinity;
+    analyzerSettings.sampleRate = audioProcessor.getSampleRate();
+
+    spectrumAggregation = (SpectrumColumnTable::Aggregation)(int)options.getProperty("aggregation",
+        (int)SpectrumColumnTable::Aggregation::Max);
+
+    //a resolution change alone is picked up by the running analyzer between two frames
+    auto onlyOrderChanged = analyzerIsRunning
+        && previousSettings.overlap == analyzerSettings.overlap
+        && previousSettings.source == analyzerSettings.source
+        && previousSettings.window == analyzerSettings.window
+        && previousSettings.averagingMs == analyzerSettings.averagingMs
+        && previousSettings.peakHold == analyzerSettings.peakHold
+        && previousSettings.multirate == analyzerSettings.multirate
+        && previousSettings.sampleRate == analyzerSettings.sampleRate;
+
+    if (onlyOrderChanged)
+    {
+        spectrumAnalyzer.setOrder(analyzerSettings.order);
+        return;
+    }
+
+    spectrumFrame = nullptr;
+    spectrumAnalyzer.start(analyzerSettings);
+    analyzerIsRunning = true;
+}
+
+void ResponseCurveComponent::mouseDown(const juce::MouseEvent& event)
+{
+    if (event.mods.isPopupMenu())
+        showAnalyzerMenu();
+}
+
+void ResponseCurveComponent::showAnalyzerMenu()
+{
+    auto options = getAnalyzerOptions();
+
+    auto addChoices = [this, &options](juce::PopupMenu& menu, const juce::Identifier& property,
+        std::initializer_list<std::pair<const char*, juce::var>> choices, const juce::var& current)
+        {
+            for (auto& choice : choices)
+            {
+                auto value = choice.second;
+                menu.addItem(choice.first, true, current == value, [this, options, property, value]() mutable
+                    {
+                        options.setProperty(property, value, nullptr);
+                        applyAnalyzerOptions();
+                    });
+            }
+        };
+
+    juce::PopupMenu source, resolution, overlap, window, averaging, aggregation;
+
+    addChoices(source, "source", { { "Pre / Post EQ", (int)AnalyzerSource::PrePost },
+        { "Left / Right", (int)AnalyzerSource::LeftRight }, { "Mid / Side", (int)AnalyzerSource::MidSide } },
+        (int)analyzerSettings.source);
+
+    addChoices(resolution, "fftOrder", { { "2048", (int)FFTOrder::order2k }, { "4096", (int)FFTOrder::order4k },
+        { "8192", (int)FFTOrder::order8k }, { "16384", (int)FFTOrder::order16k }, { "32768", (int)FFTOrder::order32k } },
+        (int)analyzerSettings.order);
+    addChoices(overlap, "overlap", { { "None", 1 }, { "50%", 2 }, { "75%", 4 }, { "87.5%", 8 } }, analyzerSettings.overlap);
+    addChoices(window, "window", { { "Hann", (int)AnalyzerWindow::Hann },
+        { "Blackman-Harris", (int)AnalyzerWindow::BlackmanHarris }, { "Flat Top", (int)AnalyzerWindow::FlatTop } },
+        (int)analyzerSettings.window);
+    addChoices(averaging, "averagingMs", { { "Off", 0.f }, { "100 ms", 100.f }, { "300 ms", 300.f }, { "1 s", 1000.f } },
+        analyzerSettings.averagingMs);
+    addChoices(aggregation, "aggregation", { { "Max", (int)SpectrumColumnTable::Aggregation::Max },
+        { "Mean", (int)SpectrumColumnTable::Aggregation::Mean } }, (int)spectrumAggregation);
+
+    juce::PopupMenu menu;
+    menu.addSectionHeader("Analyzer");
+    menu.addSubMenu("Source", source);
+    menu.addSubMenu("Resolution", resolution);
+    menu.addSubMenu("Overlap", overlap);
+    menu.addSubMenu("Window", window);
+    menu.addSubMenu("Averaging", averaging);
+    menu.addSubMenu("Bins per Pixel", aggregation);
+    menu.addItem("Peak Hold", true, analyzerSettings.peakHold, [this, options]() mutable
+        {
+            options.setProperty("peakHold", !analyzerSettings.peakHold, nullptr);
+            applyAnalyzerOptions();
+        });
+    menu.addItem("Multiresolution", true, analyzerSettings.multirate, [this, options]() mutable
+        {
+            options.setProperty("multirate", !analyzerSettings.multirate, nullptr);
+            applyAnalyzerOptions();
+        });
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(this).withMousePosition());
+}
+
+juce::Path ResponseCurveComponent::makeSpectrumPath(const std::vector<float>& levels, bool closed) const
 {
     auto fftBounds = getLocalBounds().toFloat();
     auto top = fftBounds.getY();
     auto bottom = fftBounds.getBottom();
-    auto width = fftBounds.getWidth();
 
-    int numBins = (int)fftSize / 2;
-
-    auto map = [bottom, top, negativeInfinity](float v)
+    auto map = [bottom, top](float v)
         {
-            return juce::jmap(v,
-                negativeInfinity, 0.f,
-                float(bottom), top);
+            return juce::jmap(juce::jlimit(negativeInfinity, 0.f, v), negativeInfinity, 0.f, bottom, top);
         };
 
-    auto y = map(renderData[0]);
-
-    jassert(!std::isnan(y) && !std::isinf(y));
+    juce::Path spectrum;
+    spectrum.preallocateSpace(3 * ((int)levels.size() + 3));
 
-    const int pathResolution = 1;
+    if (closed)
+        spectrum.startNewSubPath(fftBounds.getX(), bottom);
+    else if (!levels.empty())
+        spectrum.startNewSubPath(fftBounds.getX(), map(levels.front()));
 
-    int lastPixelDrawnX = 0;
+    for (size_t x = 0; x < levels.size(); ++x)
+        spectrum.lineTo(fftBounds.getX() + (float)x, map(levels[x]));
 
-    for (int binNum = 1; binNum < numBins; binNum += pathResolution)
+    if (closed)
     {
-        y = map(renderData[binNum]);
-        jassert(!std::isnan(y) && !std::isinf(y));
+        spectrum.lineTo(fftBounds.getRight(), bottom);
+        spectrum.closeSubPath();
+    }
 
-        if (!std::isnan(y) && !std::isinf(y))
-        {
-            auto binFreq = binNum * binWidth;
-            auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
-            int binX = std::floor(normalizedBinX * width);
+    return spectrum;
+}
 
+void ResponseCurveComponent::drawSpectrum(juce::Graphics& g, const SpectrumAnalyzer::Frame& frame)
+{
+    auto fftBounds = getLocalBounds().toFloat();
+    auto width = getWidth();
+    auto sampleRate = audioProcessor.getSampleRate();
 
-            if (std::round(binX) > lastPixelDrawnX)
-            {
-                float alpha = (y) / getHeight();
+    if (width <= 0 || sampleRate <= 0.0)
+        return;
 
-                g.setColour(juce::Colour::fromFloatRGBA(1.f, 0, 0, 1 - alpha));
-                g.drawVerticalLine(binX, top, bottom);
+    //the bin ranges only move on resize, FFT order or sample rate changes
+    if (spectrumColumns.needsRebuild(width, frame.fftSize, sampleRate))
+        spectrumColumns.rebuild(width, frame.fftSize, sampleRate, 20.f, 20000.f);
 
-                lastPixelDrawnX = std::round(binX);
-            }
-        }
+    //second trace first, as an outline behind the filled post EQ one
+    const auto& secondTrace = frame.traces[1];
+    auto secondary = makeSpectrumPath(spectrumColumns.aggregate(secondTrace.magnitudesDb.data(), spectrumAggregation), false);
+
+    g.setColour(frame.source == AnalyzerSource::PrePost
+        ? juce::Colour::fromFloatRGBA(0.8f, 0.8f, 0.8f, 0.5f)
+        : juce::Colour::fromFloatRGBA(0.3f, 0.7f, 1.f, 0.8f));
+    g.strokePath(secondary, juce::PathStrokeType(1.f));
+
+    const auto& firstTrace = frame.traces[0];
+    auto spectrum = makeSpectrumPath(spectrumColumns.aggregate(firstTrace.magnitudesDb.data(), spectrumAggregation), true);
+
+    //louder columns read stronger, like the old per line alpha did
+    g.setGradientFill(juce::ColourGradient(juce::Colour::fromFloatRGBA(1.f, 0, 0, 0.9f), 0.f, fftBounds.getY(),
+        juce::Colour::fromFloatRGBA(1.f, 0, 0, 0.1f), 0.f, fftBounds.getBottom(), false));
+    g.fillPath(spectrum);
+
+    if (frame.hasPeaks)
+    {
+        auto peaks = makeSpectrumPath(spectrumColumns.aggregate(firstTrace.peaksDb.data(), SpectrumColumnTable::Aggregation::Max), false);
+
+        g.setColour(juce::Colour::fromFloatRGBA(1.f, 0.6f, 0.6f, 0.8f));
+        g.strokePath(peaks, juce::PathStrokeType(1.f));
     }
-}
\ No newline at end of file
+}
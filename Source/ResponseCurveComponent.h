@@ -13,81 +13,15 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "BandThumbComponent.h"
+#include "SpectrumAnalyzer.h"
+#include "SpectrumColumnTable.h"
+#include "ResponseCurveCache.h"
 
 void drawCircleCenter(juce::Graphics& g, float x, float y, float radius);
 
 //==============================================================================
 /*
 */
-enum FFTOrder
-{
-	order2k = 11,
-	order4k = 12,
-	order8k = 13,
-	order16k = 14,
-	order32k = 15
-};
-
-template<typename BlockType>
-struct FFTDataGenerator
-{
-	void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
-	{
-		const auto fftSize = getFFTSize();
-
-		fftData.assign(fftData.size(), 0);
-		auto* readIndex = audioData.getReadPointer(0);
-		std::copy(readIndex, readIndex + fftSize, fftData.begin());
-
-		//apply windowing function
-		window->multiplyWithWindowingTable(fftData.data(), fftSize);
-
-		//render FFT data
-		forwardFFT->performFrequencyOnlyForwardTransform(fftData.data());
-
-		int numBins = (int)fftSize / 2;
-
-		//normalize fft values
-		for (int i = 0; i < numBins; ++i)
-		{
-			fftData[i] /= (float)numBins;
-		}
-
-		//convert  to dB
-		for (int i = 0; i < numBins; ++i)
-		{
-			fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
-		}
-
-		fftDataFifo.push(fftData);
-	}
-
-	void changeOrder(FFTOrder newOrder)
-	{
-		//when changing order, recreate the window, forwardFFT, fifo, fftData, fifoIndex
-
-		order = newOrder;
-		auto fftSize = getFFTSize();
-
-		forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-		window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris);
-
-		fftData.clear();
-		fftData.resize(fftSize * 2, 0);
-		fftDataFifo.prepare(fftData.size());
-	}
-	int getFFTSize() const { return 1 << order; }
-	int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }
-	bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }
-private:
-	FFTOrder order;
-	BlockType fftData;
-	std::unique_ptr<juce::dsp::FFT> forwardFFT;
-	std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
-
-	Fifo<BlockType> fftDataFifo;
-};
-
 class ResponseCurveComponent  : public juce::Component,
     juce::AudioProcessorParameter::Listener,
     juce::Timer
@@ -103,35 +37,42 @@ public:
     void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override {}
     void timerCallback() override;
 
+    void mouseDown(const juce::MouseEvent& event) override;
+
 private:
     ParametricEQ2AudioProcessor& audioProcessor;
 
     juce::Atomic<bool> parametersChanged{ false };
-    MonoChain monoChain;
+    ChainSettingsTracker chainSettingsTracker;
+    ResponseCurveCache responseCurveCache;
+    //rebuilt only when a band or the size changes, every other repaint just draws it again
+    juce::Path responseCurve;
+    bool responseCurveIsValid = false;
 
-    BandThumbComponent thumbs[3];
+    std::array<BandThumbComponent, ChainSettings::numBands> thumbs;
     static constexpr float thumbSize = 30.f;
 
     void updateResponseCurve();
     void updateThumbsFromParameters();
     void drawResultingResponseCurve(juce::Graphics& g);
 
-	SingleChannelSampleFifo<ParametricEQ2AudioProcessor::BlockType>* leftChannelFifo;
-
-	juce::AudioBuffer<float> monoBuffer;
-
-	FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+	SpectrumAnalyzer spectrumAnalyzer;
+	const SpectrumAnalyzer::Frame* spectrumFrame = nullptr;
+	SpectrumAnalyzer::Settings analyzerSettings;
+	bool analyzerIsRunning = false;
 
-	//AnalyzerPathGenerator<juce::Path> pathProducer;
+	//Analyzer options live in the plugin state next to the parameters, so they are saved with it
+	juce::ValueTree getAnalyzerOptions();
+	void applyAnalyzerOptions();
+	void showAnalyzerMenu();
 
+	SpectrumColumnTable spectrumColumns;
+	SpectrumColumnTable::Aggregation spectrumAggregation = SpectrumColumnTable::Aggregation::Max;
 
-	juce::Path leftChannelFFTPath;
+	static constexpr float negativeInfinity = -48.f;
 
-	void drawFFTLines(juce::Graphics& g,
-		const std::vector<float>& renderData,
-		int fftSize,
-		float binWidth,
-		float negativeInfinity);
+	void drawSpectrum(juce::Graphics& g, const SpectrumAnalyzer::Frame& frame);
+	juce::Path makeSpectrumPath(const std::vector<float>& levels, bool closed) const;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResponseCurveComponent)
 };
@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    SampleRing.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//Single producer / single consumer ring of raw samples, several channels sharing one
+//read and one write position. The producer copies whole blocks (at most two memcpys per
+//channel), the consumer reads the contiguous spans in place and then discards them.
+class SampleRing
+{
+public:
+	//A channel's readable samples, split in two where the ring wraps around
+	struct Span
+	{
+		const float* data1 = nullptr;
+		int size1 = 0;
+		const float* data2 = nullptr;
+		int size2 = 0;
+	};
+
+	//Not thread safe, call while neither side is running
+	void prepare(int numChannelsToUse, int minimumCapacity)
+	{
+		numChannels = numChannelsToUse;
+		capacity = juce::nextPowerOfTwo(juce::jmax(minimumCapacity, 1));
+		mask = (size_t)capacity - 1;
+
+		storage.assign((size_t)(numChannels * capacity), 0.f);
+		writePosition.store(0);
+		readPosition.store(0);
+	}
+
+	int getNumChannels() const { return numChannels; }
+	int getCapacity() const { return capacity; }
+
+	//Producer: reserves room for one block, returns false if the consumer has fallen too far
+	//behind, in which case the block is dropped and nothing else may be called for it
+	bool beginWrite(int numSamples)
+	{
+		pendingWrite = writePosition.load(std::memory_order_relaxed);
+		const auto read = readPosition.load(std::memory_order_acquire);
+
+		return numSamples <= capacity - (int)(pendingWrite - read);
+	}
+
+	//Copies one channel of the reserved block, channels can be filled at different points of the callback
+	void writeChannel(int channel, const float* data, int numSamples)
+	{
+		jassert(juce::isPositiveAndBelow(channel, numChannels));
+
+		const auto start = (int)(pendingWrite & mask);
+		const auto firstPart = juce::jmin(numSamples, capacity - start);
+
+		auto* destination = getChannel(channel);
+		std::memcpy(destination + start, data, sizeof(float) * (size_t)firstPart);
+		std::memcpy(destination, data + firstPart, sizeof(float) * (size_t)(numSamples - firstPart));
+	}
+
+	//Makes the reserved block visible to the consumer
+	void finishWrite(int numSamples)
+	{
+		writePosition.store(pendingWrite + (size_t)numSamples, std::memory_order_release);
+	}
+
+	//Consumer
+	int getNumReady() const
+	{
+		return (int)(writePosition.load(std::memory_order_acquire) - readPosition.load(std::memory_order_relaxed));
+	}
+
+	//The oldest numSamples of a channel, read in place. Stays valid until discard().
+	Span getReadSpan(int channel, int numSamples) const
+	{
+		jassert(numSamples <= getNumReady());
+
+		const auto start = (int)(readPosition.load(std::memory_order_relaxed) & mask);
+		const auto firstPart = juce::jmin(numSamples, capacity - start);
+		const auto* data = getChannel(channel);
+
+		return { data + start, firstPart, data, numSamples - firstPart };
+	}
+
+	void discard(int numSamples)
+	{
+		readPosition.store(readPosition.load(std::memory_order_relaxed) + (size_t)numSamples, std::memory_order_release);
+	}
+
+private:
+	float* getChannel(int channel) { return storage.data() + channel * capacity; }
+	const float* getChannel(int channel) const { return storage.data() + channel * capacity; }
+
+	std::vector<float> storage;
+	int numChannels = 0;
+	int capacity = 0;
+	size_t mask = 0;
+
+	size_t pendingWrite = 0;
+	std::atomic<size_t> writePosition{ 0 };
+	std::atomic<size_t> readPosition{ 0 };
+};
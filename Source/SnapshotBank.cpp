@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    SnapshotBank.cpp
+
+  ==============================================================================
+*/
+
+#include "SnapshotBank.h"
+
+SnapshotBank::SnapshotBank(juce::AudioProcessor& owner, const ParameterHandles& parameterHandles, CoefficientDesigner& coefficientDesigner,
+	const juce::AudioProcessorParameter& selectorParameter)
+	: processor(owner), parameters(parameterHandles), designer(coefficientDesigner), selector(selectorParameter)
+{
+}
+
+void SnapshotBank::store(int slot)
+{
+	jassert(juce::isPositiveAndBelow(slot, numSlots));
+
+	auto& snapshot = snapshots[(size_t)slot];
+	const auto& processorParameters = processor.getParameters();
+
+	snapshot.values.resize((size_t)processorParameters.size());
+
+	for (int i = 0; i < processorParameters.size(); ++i)
+		snapshot.values[(size_t)i] = processorParameters[i]->getValue();
+
+	//designed now, at the current rate, so recalling costs the audio thread nothing but a copy.
+	//Before the host has prepared the processor there is no rate yet; the settings are kept and
+	//recall designs them once there is one.
+	const auto hostRate = designer.getSampleRate();
+	const auto chainSettings = parameters.getChainSettings();
+
+	if (hostRate > 0.0)
+	{
+		snapshot.coefficientSet = designCoefficientSet(chainSettings, hostRate);
+	}
+	else
+	{
+		snapshot.coefficientSet = {};
+		snapshot.coefficientSet.chainSettings = chainSettings;
+	}
+
+	snapshot.stored = true;
+}
+
+bool SnapshotBank::recall(int slot)
+{
+	if (!hasSnapshot(slot))
+		return false;
+
+	auto& snapshot = snapshots[(size_t)slot];
+	const auto& processorParameters = processor.getParameters();
+
+	//the parameters go first: any set the designer starts after the generation below moves on
+	//has then read the snapshot's values, and anything older is dropped by the audio thread
+	for (int i = 0; i < processorParameters.size() && i < (int)snapshot.values.size(); ++i)
+	{
+		auto* parameter = processorParameters[i];
+		const auto value = snapshot.values[(size_t)i];
+
+		if (parameter == &selector)
+			continue;
+
+		//each change is its own gesture, so automation writing hosts record it like a user's edit
+		if (parameter->getValue() != value)
+		{
+			parameter->beginChangeGesture();
+			parameter->setValueNotifyingHost(value);
+			parameter->endChangeGesture();
+		}
+	}
+
+	const auto hostRate = designer.getSampleRate();
+
+	if (hostRate > 0.0)
+	{
+		//stored before prepareToPlay, or the host changed rate since
+		auto& stored = snapshot.coefficientSet;
+		if (stored.sampleRate != hostRate * stored.chainSettings.getOversamplingFactor())
+			stored = designCoefficientSet(stored.chainSettings, hostRate);
+
+		auto& recalledSet = recalledSets.getWriteBuffer();
+		recalledSet = stored;
+		recalledSet.generation = designer.advanceGeneration();
+		recalledSets.publish();
+	}
+
+	//the designer catches up in the background, for the linear phase kernel and its own tracking
+	designer.requestUpdate();
+	return true;
+}
+
+bool SnapshotBank::hasSnapshot(int slot) const
+{
+	return juce::isPositiveAndBelow(slot, numSlots) && snapshots[(size_t)slot].stored;
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    SnapshotBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "ParameterHandles.h"
+#include "CoefficientDesigner.h"
+#include "TripleBuffer.h"
+
+//In memory A / B / C / D snapshots of every parameter. Each one keeps the coefficient set designed
+//for it when it was stored, so recalling it hands the audio thread a finished set in a single
+//TripleBuffer publish: the sound switches on the next block, without waiting on the designer and
+//without going through the state tree. The parameters are moved to match for the host and editor,
+//all but the selector parameter that picks the snapshot, which a recall must not move.
+class SnapshotBank
+{
+public:
+	static constexpr int numSlots = 4;
+
+	SnapshotBank(juce::AudioProcessor& processor, const ParameterHandles& parameters, CoefficientDesigner& designer,
+		const juce::AudioProcessorParameter& selector);
+
+	//Message thread only, the recalled sets have a single producer
+	void store(int slot);
+	bool recall(int slot);
+	bool hasSnapshot(int slot) const;
+
+	static juce::String getSlotName(int slot) { return juce::String::charToString((juce::juce_wchar)('A' + slot)); }
+
+	//Audio thread only: the set of the last recalled snapshot if one was recalled since the last call
+	const CoefficientSet* acquire() { return recalledSets.acquire(); }
+
+private:
+	struct Snapshot
+	{
+		bool stored = false;
+		//normalised, in the processor's parameter order
+		std::vector<float> values;
+		CoefficientSet coefficientSet;
+	};
+
+	juce::AudioProcessor& processor;
+	const ParameterHandles& parameters;
+	CoefficientDesigner& designer;
+	const juce::AudioProcessorParameter& selector;
+
+	std::array<Snapshot, numSlots> snapshots;
+	TripleBuffer<CoefficientSet> recalledSets;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SnapshotBank)
+};
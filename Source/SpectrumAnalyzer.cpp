@@ -0,0 +1,439 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer(SampleRing& sampleRing)
+	: juce::Thread("Spectrum Analyzer"), ring(sampleRing)
+{
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+	stop();
+}
+
+static juce::dsp::WindowingFunction<float>::WindowingMethod getWindowingMethod(AnalyzerWindow window)
+{
+	switch (window)
+	{
+	case AnalyzerWindow::Hann: return juce::dsp::WindowingFunction<float>::hann;
+	case AnalyzerWindow::FlatTop: return juce::dsp::WindowingFunction<float>::flatTop;
+	case AnalyzerWindow::BlackmanHarris: break;
+	}
+
+	return juce::dsp::WindowingFunction<float>::blackmanHarris;
+}
+
+void SpectrumAnalyzer::start(const Settings& newSettings)
+{
+	stop();
+
+	//the window is baked into every cached plan
+	if (newSettings.window != settings.window)
+		for (auto& plan : plans)
+			plan = {};
+
+	settings = newSettings;
+	requestedOrder.store((int)settings.order);
+	currentOrder = 0;
+	numStages = 0;
+	samplesToSkip = 0;
+
+	packedSignal.assign((size_t)maxFFTSize, {});
+	packedSpectrum.assign((size_t)maxFFTSize, {});
+	scratch.assign((size_t)maxFFTSize, 0.f);
+
+	for (auto& signal : traceSignals)
+		signal.assign((size_t)maxFFTSize, 0.f);
+
+	for (auto& channelHistory : stages[0].history)
+		channelHistory.assign((size_t)maxFFTSize, 0.f);
+
+	stages[0].historyWritePosition = 0;
+
+	//whatever piled up while nobody was listening is stale
+	ring.discard(ring.getNumReady());
+
+	startThread();
+}
+
+void SpectrumAnalyzer::stop()
+{
+	stopThread(1000);
+}
+
+SpectrumAnalyzer::Plan& SpectrumAnalyzer::getPlan(int order)
+{
+	auto& plan = plans[(size_t)(order - FFTOrder::order2k)];
+
+	if (plan.fft == nullptr)
+	{
+		plan.fft = std::make_unique<juce::dsp::FFT>(order);
+		const auto size = 1 << order;
+		plan.window.assign((size_t)size, 0.f);
+		juce::dsp::WindowingFunction<float>::fillWindowingTables(plan.window.data(), (size_t)size,
+			getWindowingMethod(settings.window), false);
+
+		auto sum = 0.0;
+		for (auto w : plan.window)
+			sum += w;
+
+		plan.coherentGain = (float)(sum / size);
+	}
+
+	return plan;
+}
+
+void SpectrumAnalyzer::applyOrder(int order)
+{
+	currentOrder = juce::jlimit((int)FFTOrder::order2k, (int)FFTOrder::order32k, order);
+	gridSize = 1 << currentOrder;
+	analysedSinceLastFrame = false;
+
+	const auto stageOrder = settings.multirate ? juce::jmin(currentOrder, multirateStageOrder) : currentOrder;
+	const auto previousNumStages = numStages;
+	numStages = currentOrder - stageOrder + 1;
+
+	for (int s = 0; s < numStages; ++s)
+	{
+		auto& stage = stages[(size_t)s];
+
+		//in multirate mode a resolution change mostly just adds or drops stages at the bottom. A stage
+		//that carries on at the same size and rate keeps its history, averages and decimator, so its
+		//octaves don't drop to the floor while a fresh window fills.
+		const auto keepsState = s < previousNumStages && stage.fftSize == (1 << stageOrder) && stage.decimation == (1 << s);
+		//a decimator only holds anything useful if it was already feeding the stage below
+		const auto keepsDecimators = keepsState && s + 1 < previousNumStages;
+
+		stage.fftSize = 1 << stageOrder;
+		stage.decimation = 1 << s;
+		stage.plan = &getPlan(stageOrder);
+		stage.hopSize = juce::jmax(1, stage.fftSize / juce::jmax(1, settings.overlap));
+
+		const auto hopSeconds = stage.hopSize * stage.decimation / juce::jmax(1.0, settings.sampleRate);
+		stage.averagingCoefficient = settings.averagingMs > 0.f
+			? (float)std::exp(-hopSeconds * 1000.0 / settings.averagingMs)
+			: 0.f;
+		stage.peakDecayPerHopDb = (float)(settings.peakDecayDbPerSecond * hopSeconds);
+
+		//each stage keeps the octave(s) its window resolves best: the top one everything above
+		//an eighth of the rate, the middle ones one octave each, the lowest one everything below.
+		//Lower stages never go past a quarter of their own rate, far inside the decimators' passband.
+		const auto numBins = stage.fftSize / 2;
+		stage.firstBin = s == numStages - 1 ? 0 : stage.fftSize / 8;
+		stage.endBin = s == 0 ? numBins : stage.fftSize / 4;
+
+		if (!keepsDecimators)
+		{
+			for (auto& decimator : stage.decimators)
+				decimator.reset();
+		}
+
+		if (keepsState)
+			continue;
+
+		stage.samplesSinceTransform = 0;
+
+		//the top stage's history is always full length and carries on, new lower ones start over
+		if (s > 0)
+		{
+			for (auto& channelHistory : stage.history)
+				channelHistory.assign((size_t)stage.fftSize, 0.f);
+
+			stage.historyWritePosition = 0;
+			stage.samplesUntilFull = stage.fftSize;
+		}
+
+		//bins mean different frequencies now, so averages and peaks start over
+		for (int t = 0; t < numTraces; ++t)
+		{
+			stage.averagedPower[t].assign((size_t)numBins, 0.f);
+			stage.peaksDb[t].assign((size_t)numBins, settings.negativeInfinityDb);
+		}
+	}
+}
+
+void SpectrumAnalyzer::run()
+{
+	while (!threadShouldExit())
+	{
+		if (auto order = requestedOrder.load(); order != currentOrder)
+		{
+			applyOrder(order);
+
+			//the top stage's history already holds a full window, so the new resolution shows up right away
+			analyseWindow(stages[0]);
+			publishFrame();
+		}
+
+		auto numReady = ring.getNumReady();
+
+		if (numReady > 0)
+		{
+			samplesToSkip = juce::jmax(0, numReady - maxHopsPerPass * stages[0].hopSize);
+
+			Spans spans;
+			for (int ch = 0; ch < numAnalyzerChannels; ++ch)
+				spans[ch] = ring.getReadSpan(ch, numReady);
+
+			consume(spans, numReady);
+			ring.discard(numReady);
+
+			//the display only ever needs the state after the last hop of this pass
+			if (analysedSinceLastFrame)
+				publishFrame();
+		}
+
+		wait(analysisIntervalMs);
+	}
+}
+
+void SpectrumAnalyzer::consume(const Spans& spans, int numSamples)
+{
+	auto& top = stages[0];
+	int offset = 0;
+
+	while (offset < numSamples)
+	{
+		auto chunk = juce::jmin(numSamples - offset, top.hopSize - top.samplesSinceTransform);
+		pushIntoHistory(top, spans, offset, chunk);
+
+		if (numStages > 1)
+			decimateIntoNextStage(spans, offset, chunk);
+
+		offset += chunk;
+		top.samplesSinceTransform += chunk;
+
+		if (top.samplesSinceTransform == top.hopSize)
+		{
+			top.samplesSinceTransform = 0;
+
+			if (samplesToSkip > 0)
+				samplesToSkip = juce::jmax(0, samplesToSkip - top.hopSize);
+			else
+				analyseWindow(top);
+		}
+	}
+}
+
+void SpectrumAnalyzer::pushIntoHistory(Stage& stage, const Spans& spans, int offset, int numSamples)
+{
+	//numSamples never exceeds a hop, so it always fits the history
+	for (int ch = 0; ch < numAnalyzerChannels; ++ch)
+	{
+		const auto& span = spans[ch];
+		auto& channelHistory = stage.history[ch];
+		const auto length = (int)channelHistory.size();
+		auto writePosition = stage.historyWritePosition;
+
+		auto copy = [&](const float* source, int count)
+			{
+				auto firstPart = juce::jmin(count, length - writePosition);
+				std::copy(source, source + firstPart, channelHistory.begin() + writePosition);
+				std::copy(source + firstPart, source + count, channelHistory.begin());
+				writePosition = (writePosition + count) & (length - 1);
+			};
+
+		auto fromFirst = juce::jlimit(0, numSamples, span.size1 - offset);
+		copy(span.data1 + offset, fromFirst);
+		copy(span.data2 + juce::jmax(0, offset - span.size1), numSamples - fromFirst);
+	}
+
+	stage.historyWritePosition = (stage.historyWritePosition + numSamples) & ((int)stage.history[0].size() - 1);
+}
+
+void SpectrumAnalyzer::decimateIntoNextStage(const Spans& spans, int offset, int numSamples)
+{
+	auto& decimators = stages[0].decimators;
+
+	for (int i = offset; i < offset + numSamples; ++i)
+	{
+		float decimated[numAnalyzerChannels];
+		bool produced = false;
+
+		//all channels run in lockstep, so they produce their outputs on the same samples
+		for (int ch = 0; ch < numAnalyzerChannels; ++ch)
+		{
+			const auto& span = spans[ch];
+			auto sample = i < span.size1 ? span.data1[i] : span.data2[i - span.size1];
+			produced = decimators[ch].process(sample, decimated[ch]);
+		}
+
+		if (produced)
+			pushIntoStage(1, decimated);
+	}
+}
+
+void SpectrumAnalyzer::pushIntoStage(int stageIndex, const float* samples)
+{
+	auto& stage = stages[(size_t)stageIndex];
+	const auto mask = (int)stage.history[0].size() - 1;
+
+	for (int ch = 0; ch < numAnalyzerChannels; ++ch)
+		stage.history[ch][(size_t)stage.historyWritePosition] = samples[ch];
+
+	stage.historyWritePosition = (stage.historyWritePosition + 1) & mask;
+	stage.samplesUntilFull = juce::jmax(0, stage.samplesUntilFull - 1);
+
+	if (stageIndex + 1 < numStages)
+	{
+		float decimated[numAnalyzerChannels];
+		bool produced = false;
+
+		for (int ch = 0; ch < numAnalyzerChannels; ++ch)
+			produced = stage.decimators[ch].process(samples[ch], decimated[ch]);
+
+		if (produced)
+			pushIntoStage(stageIndex + 1, decimated);
+	}
+
+	if (++stage.samplesSinceTransform == stage.hopSize)
+	{
+		stage.samplesSinceTransform = 0;
+		analyseWindow(stage);
+	}
+}
+
+void SpectrumAnalyzer::unrollHistory(const Stage& stage, int channel, float* destination) const
+{
+	//the newest fftSize samples, oldest first
+	const auto& channelHistory = stage.history[channel];
+	const auto length = (int)channelHistory.size();
+	auto start = (stage.historyWritePosition - stage.fftSize) & (length - 1);
+	auto firstPart = juce::jmin(stage.fftSize, length - start);
+	std::copy(channelHistory.begin() + start, channelHistory.begin() + start + firstPart, destination);
+	std::copy(channelHistory.begin(), channelHistory.begin() + (stage.fftSize - firstPart), destination + firstPart);
+}
+
+void SpectrumAnalyzer::makeTraceSignals(const Stage& stage)
+{
+	using FVO = juce::FloatVectorOperations;
+
+	auto* first = traceSignals[0].data();
+	auto* second = traceSignals[1].data();
+	const auto fftSize = stage.fftSize;
+
+	switch (settings.source)
+	{
+	case AnalyzerSource::PrePost:
+		unrollHistory(stage, PostLeft, first);
+		unrollHistory(stage, PostRight, scratch.data());
+		FVO::add(first, scratch.data(), fftSize);
+		FVO::multiply(first, 0.5f, fftSize);
+
+		unrollHistory(stage, PreLeft, second);
+		unrollHistory(stage, PreRight, scratch.data());
+		FVO::add(second, scratch.data(), fftSize);
+		FVO::multiply(second, 0.5f, fftSize);
+		break;
+
+	case AnalyzerSource::LeftRight:
+		unrollHistory(stage, PostLeft, first);
+		unrollHistory(stage, PostRight, second);
+		break;
+
+	case AnalyzerSource::MidSide:
+		unrollHistory(stage, PostLeft, first);
+		unrollHistory(stage, PostRight, scratch.data());
+		FVO::copy(second, first, fftSize);
+		FVO::add(first, scratch.data(), fftSize);
+		FVO::subtract(second, scratch.data(), fftSize);
+		FVO::multiply(first, 0.5f, fftSize);
+		FVO::multiply(second, 0.5f, fftSize);
+		break;
+	}
+}
+
+void SpectrumAnalyzer::analyseWindow(Stage& stage)
+{
+	const auto fftSize = stage.fftSize;
+	makeTraceSignals(stage);
+
+	for (auto& signal : traceSignals)
+		juce::FloatVectorOperations::multiply(signal.data(), stage.plan->window.data(), fftSize);
+
+	//two real signals in one complex transform: x = a + jb
+	for (int i = 0; i < fftSize; ++i)
+		packedSignal[i] = { traceSignals[0][i], traceSignals[1][i] };
+
+	stage.plan->fft->perform(packedSignal.data(), packedSpectrum.data(), false);
+
+	const auto numBins = fftSize / 2;
+	//a full scale sine gives |X| = coherent gain * N / 2 in its bin
+	const auto coherentGain = stage.plan->coherentGain;
+	const auto normalisation = 1.f / ((float)numBins * (float)numBins * coherentGain * coherentGain);
+	const auto smoothing = stage.averagingCoefficient;
+	analysedSinceLastFrame = true;
+
+	for (int k = 0; k < numBins; ++k)
+	{
+		//A[k] = (X[k] + X*[N-k]) / 2, B[k] = (X[k] - X*[N-k]) / 2j
+		auto x = packedSpectrum[k];
+		auto mirrored = std::conj(packedSpectrum[(fftSize - k) & (fftSize - 1)]);
+
+		float power[numTraces] = { std::norm(x + mirrored) * 0.25f, std::norm(x - mirrored) * 0.25f };
+
+		//averaging on power rather than dB keeps noise floors where they belong
+		for (int t = 0; t < numTraces; ++t)
+			stage.averagedPower[t][k] = smoothing * stage.averagedPower[t][k] + (1.f - smoothing) * power[t] * normalisation;
+	}
+
+	if (settings.peakHold)
+	{
+		for (int t = 0; t < numTraces; ++t)
+		{
+			for (int k = 0; k < numBins; ++k)
+			{
+				auto levelDb = juce::Decibels::gainToDecibels(std::sqrt(stage.averagedPower[t][k]), settings.negativeInfinityDb);
+				stage.peaksDb[t][k] = juce::jmax(levelDb, stage.peaksDb[t][k] - stage.peakDecayPerHopDb);
+			}
+		}
+	}
+}
+
+void SpectrumAnalyzer::publishFrame()
+{
+	auto& frame = frames.getWriteBuffer();
+
+	//stages fill from the top down, so the lowest one with a full window covers everything below it
+	auto lastFullStage = numStages - 1;
+	while (lastFullStage > 0 && stages[(size_t)lastFullStage].samplesUntilFull > 0)
+		--lastFullStage;
+
+	for (int t = 0; t < numTraces; ++t)
+	{
+		auto& trace = frame.traces[t];
+
+		for (int s = 0; s <= lastFullStage; ++s)
+		{
+			const auto& stage = stages[(size_t)s];
+
+			//each stage bin covers this many bins of the output grid
+			const auto binsPerStageBin = gridSize / (stage.fftSize * stage.decimation);
+			const auto firstBin = s == lastFullStage ? 0 : stage.firstBin;
+
+			for (int k = firstBin; k < stage.endBin; ++k)
+			{
+				auto levelDb = juce::Decibels::gainToDecibels(std::sqrt(stage.averagedPower[t][k]), settings.negativeInfinityDb);
+				std::fill_n(trace.magnitudesDb.begin() + k * binsPerStageBin, binsPerStageBin, levelDb);
+
+				if (settings.peakHold)
+					std::fill_n(trace.peaksDb.begin() + k * binsPerStageBin, binsPerStageBin, stage.peaksDb[t][k]);
+			}
+		}
+	}
+
+	frame.source = settings.source;
+	frame.hasPeaks = settings.peakHold;
+	frame.numBins = gridSize / 2;
+	frame.fftSize = gridSize;
+
+	frames.publish();
+	analysedSinceLastFrame = false;
+}
@@ -0,0 +1,197 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SampleRing.h"
+#include "TripleBuffer.h"
+#include "HalfbandDecimator.h"
+
+enum FFTOrder
+{
+	order2k = 11,
+	order4k = 12,
+	order8k = 13,
+	order16k = 14,
+	order32k = 15
+};
+
+enum class AnalyzerWindow
+{
+	Hann,
+	BlackmanHarris,
+	FlatTop
+};
+
+//Channels of the processor's analyzer ring, written from the audio thread before and after the filters
+enum AnalyzerChannel
+{
+	PreLeft,
+	PreRight,
+	PostLeft,
+	PostRight,
+	numAnalyzerChannels
+};
+
+//What the two traces of a frame show. The first is always post EQ.
+enum class AnalyzerSource
+{
+	PrePost,   //post EQ mono sum, pre EQ mono sum
+	LeftRight, //post EQ left, post EQ right
+	MidSide    //post EQ mid, post EQ side
+};
+
+//Turns the samples the processor pushes into its analyzer ring into render ready spectra
+//on a background thread, so the message thread only picks up the latest result.
+//Transforms run at a fixed hop, so averaging and peak decay behave the same whatever
+//block size the host uses or however late the thread wakes up. Both traces come out of
+//a single complex FFT, one real signal packed in the real part and one in the imaginary.
+//
+//In multirate mode the signal is also halved in rate octave by octave and each stage gets
+//its own small FFT: the top stage covers the treble with a short window, the lowest one
+//reaches the bass resolution of the selected size, and the stages are stitched together
+//on the selected size's bin grid so the display doesn't need to know.
+class SpectrumAnalyzer : private juce::Thread
+{
+public:
+	static constexpr int maxFFTSize = 1 << FFTOrder::order32k;
+	static constexpr int maxBins = maxFFTSize / 2;
+
+	struct Settings
+	{
+		FFTOrder order = FFTOrder::order8k;
+		int overlap = 4; //transforms per fftSize samples, the hop is fftSize / overlap
+		AnalyzerSource source = AnalyzerSource::PrePost;
+		AnalyzerWindow window = AnalyzerWindow::BlackmanHarris;
+		float averagingMs = 0.f; //exponential averaging time constant on power, 0 is off
+		bool peakHold = false;
+		bool multirate = false;
+		float peakDecayDbPerSecond = 12.f;
+		float negativeInfinityDb = -48.f;
+		double sampleRate = 44100.0;
+	};
+
+	static constexpr int numTraces = 2;
+
+	struct Trace
+	{
+		std::array<float, maxBins> magnitudesDb{};
+		std::array<float, maxBins> peaksDb{};
+	};
+
+	struct Frame
+	{
+		std::array<Trace, numTraces> traces;
+		AnalyzerSource source = AnalyzerSource::PrePost;
+		bool hasPeaks = false;
+		int numBins = 0;
+		int fftSize = 0;
+	};
+
+	SpectrumAnalyzer(SampleRing& ring);
+	~SpectrumAnalyzer() override;
+
+	void start(const Settings& newSettings);
+	void stop();
+
+	//Any thread: the analyzer moves to the new resolution between two frames, keeping its
+	//history, so the display never drops out while switching
+	void setOrder(FFTOrder newOrder) { requestedOrder.store((int)newOrder); }
+
+	//Message thread: newest frame if one was produced since the last call, nullptr otherwise.
+	//The frame stays valid until the next call.
+	const Frame* getLatestFrame() { return frames.acquire(); }
+
+private:
+	void run() override;
+	using Spans = std::array<SampleRing::Span, numAnalyzerChannels>;
+
+	//FFT plan and window table for one resolution, built the first time it is used
+	struct Plan
+	{
+		std::unique_ptr<juce::dsp::FFT> fft;
+		std::vector<float> window;
+		//sum(window) / N: what a bin centred sine is scaled by, so every window reads 0 dBFS alike
+		float coherentGain = 1.f;
+	};
+
+	//One resolution of the analysis: its own sample rate, history and running averages
+	struct Stage
+	{
+		int fftSize = 0;
+		int hopSize = 0;
+		int decimation = 1;
+		int samplesSinceTransform = 0;
+		float averagingCoefficient = 0.f;
+		float peakDecayPerHopDb = 0.f;
+		Plan* plan = nullptr;
+
+		//the stage's bins that make it into the frame, the rest belongs to other stages
+		int firstBin = 0;
+		int endBin = 0;
+
+		//samples a stage that just started still needs before its window holds only real signal;
+		//until then the stage above keeps covering its octaves
+		int samplesUntilFull = 0;
+
+		//sliding analysis windows, written circularly instead of shifted on every buffer
+		std::array<std::vector<float>, numAnalyzerChannels> history;
+		int historyWritePosition = 0;
+
+		std::array<std::vector<float>, numTraces> averagedPower;
+		std::array<std::vector<float>, numTraces> peaksDb;
+
+		//feed the next stage down
+		std::array<HalfbandDecimator, numAnalyzerChannels> decimators;
+	};
+
+	static constexpr int maxStages = FFTOrder::order32k - FFTOrder::order2k + 1;
+	//the size each multirate stage runs at
+	static constexpr int multirateStageOrder = FFTOrder::order4k;
+
+	Plan& getPlan(int order);
+	void applyOrder(int order);
+	void consume(const Spans& spans, int numSamples);
+	void pushIntoHistory(Stage& stage, const Spans& spans, int offset, int numSamples);
+	void pushIntoStage(int stageIndex, const float* samples);
+	void decimateIntoNextStage(const Spans& spans, int offset, int numSamples);
+	void unrollHistory(const Stage& stage, int channel, float* destination) const;
+	void makeTraceSignals(const Stage& stage);
+	void analyseWindow(Stage& stage);
+	void publishFrame();
+
+	SampleRing& ring;
+
+	Settings settings;
+	std::atomic<int> requestedOrder{ FFTOrder::order8k };
+	int currentOrder = 0;
+	int gridSize = 0;
+	int samplesToSkip = 0;
+	bool analysedSinceLastFrame = false;
+
+	//one plan and one window table per size, shared by both traces and by every stage
+	std::array<Plan, FFTOrder::order32k - FFTOrder::order2k + 1> plans;
+	std::vector<juce::dsp::Complex<float>> packedSignal, packedSpectrum;
+	std::array<std::vector<float>, numTraces> traceSignals;
+	std::vector<float> scratch;
+
+	//the top stage's history is always maxFFTSize long, so any resolution can be switched
+	//to without waiting for samples
+	std::array<Stage, maxStages> stages;
+	int numStages = 0;
+
+	TripleBuffer<Frame> frames;
+
+	static constexpr int analysisIntervalMs = 15;
+
+	//after a stall only the newest hops are analysed, older ones would never be seen anyway
+	static constexpr int maxHopsPerPass = 64;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
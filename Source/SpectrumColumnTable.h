@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    SpectrumColumnTable.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Maps the bins of an analyzer frame onto the pixel columns of a log frequency axis.
+//The ranges only depend on width, FFT size and sample rate, so they are worked out once
+//and each frame is reduced to one level per column with vectorised range operations.
+class SpectrumColumnTable
+{
+public:
+	enum class Aggregation
+	{
+		Max,
+		Mean
+	};
+
+	bool needsRebuild(int width, int fftSize, double sampleRate) const
+	{
+		return width != numColumns || fftSize != tableFFTSize || sampleRate != tableSampleRate;
+	}
+
+	void rebuild(int width, int fftSize, double sampleRate, float minFreq, float maxFreq)
+	{
+		numColumns = width;
+		tableFFTSize = fftSize;
+		tableSampleRate = sampleRate;
+
+		columns.resize((size_t)juce::jmax(0, width));
+		levels.resize(columns.size());
+		runningSums.resize((size_t)fftSize / 2 + 1);
+
+		const auto binWidth = sampleRate / (double)fftSize;
+		const auto numBins = fftSize / 2;
+
+		for (int x = 0; x < width; ++x)
+		{
+			auto startBin = juce::mapToLog10((double)x / width, (double)minFreq, (double)maxFreq) / binWidth;
+			auto endBin = juce::mapToLog10((double)(x + 1) / width, (double)minFreq, (double)maxFreq) / binWidth;
+
+			auto& column = columns[(size_t)x];
+			column.firstBin = juce::jlimit(1, numBins, (int)std::ceil(startBin));
+			column.numBins = juce::jlimit(0, numBins - column.firstBin, (int)std::ceil(endBin) - column.firstBin);
+
+			//at the low end several columns share one bin, so those interpolate between neighbours instead
+			auto centre = juce::jlimit(0.0, (double)(numBins - 2), 0.5 * (startBin + endBin));
+			column.interpolationBin = (int)centre;
+			column.interpolationFraction = (float)(centre - column.interpolationBin);
+		}
+	}
+
+	//One level per column, valid until the next call or rebuild
+	const std::vector<float>& aggregate(const float* binLevels, Aggregation aggregation)
+	{
+		//one pass of running sums turns every column mean into a subtraction
+		if (aggregation == Aggregation::Mean)
+		{
+			runningSums[0] = 0.0;
+			for (size_t bin = 1; bin < runningSums.size(); ++bin)
+				runningSums[bin] = runningSums[bin - 1] + binLevels[bin - 1];
+		}
+
+		for (size_t x = 0; x < columns.size(); ++x)
+		{
+			const auto& column = columns[x];
+
+			if (column.numBins == 0)
+			{
+				auto a = binLevels[column.interpolationBin];
+				auto b = binLevels[column.interpolationBin + 1];
+				levels[x] = a + (b - a) * column.interpolationFraction;
+			}
+			else if (aggregation == Aggregation::Max || column.numBins == 1)
+			{
+				levels[x] = juce::FloatVectorOperations::findMaximum(binLevels + column.firstBin, column.numBins);
+			}
+			else
+			{
+				auto sum = runningSums[(size_t)(column.firstBin + column.numBins)] - runningSums[(size_t)column.firstBin];
+				levels[x] = (float)(sum / column.numBins);
+			}
+		}
+
+		return levels;
+	}
+
+private:
+	struct Column
+	{
+		int firstBin = 0;
+		int numBins = 0;
+		int interpolationBin = 0;
+		float interpolationFraction = 0.f;
+	};
+
+	std::vector<Column> columns;
+	std::vector<float> levels;
+	std::vector<double> runningSums;
+
+	int numColumns = -1;
+	int tableFFTSize = 0;
+	double tableSampleRate = 0.0;
+};
@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    SvfEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "SvfEngine.h"
+
+static float getPrewarpedGain(float freq, double sampleRate)
+{
+	//keep clear of Nyquist where tan() blows up
+	auto clampedFreq = juce::jmin((double)freq, sampleRate * 0.49);
+	return (float)std::tan(juce::MathConstants<double>::pi * clampedFreq / sampleRate);
+}
+
+static SvfCoefficients makeSvf(float g, float k)
+{
+	SvfCoefficients coefficients;
+
+	coefficients.a1 = 1.f / (1.f + g * (g + k));
+	coefficients.a2 = g * coefficients.a1;
+	coefficients.a3 = g * coefficients.a2;
+
+	return coefficients;
+}
+
+SvfCoefficients makeSvfPeak(float freq, float gainDb, float q, double sampleRate)
+{
+	auto A = std::pow(10.f, gainDb / 40.f);
+	auto k = 1.f / (q * A);
+
+	auto coefficients = makeSvf(getPrewarpedGain(freq, sampleRate), k);
+	coefficients.m0 = 1.f;
+	coefficients.m1 = k * (A * A - 1.f);
+	coefficients.m2 = 0.f;
+
+	return coefficients;
+}
+
+SvfCoefficients makeSvfLowPass(float freq, float q, double sampleRate)
+{
+	auto coefficients = makeSvf(getPrewarpedGain(freq, sampleRate), 1.f / q);
+	coefficients.m0 = 0.f;
+	coefficients.m1 = 0.f;
+	coefficients.m2 = 1.f;
+
+	return coefficients;
+}
+
+SvfCoefficients makeSvfHighPass(float freq, float q, double sampleRate)
+{
+	auto k = 1.f / q;
+
+	auto coefficients = makeSvf(getPrewarpedGain(freq, sampleRate), k);
+	coefficients.m0 = 1.f;
+	coefficients.m1 = -k;
+	coefficients.m2 = -1.f;
+
+	return coefficients;
+}
+
+//Q of section k in a Butterworth cascade of the given (even) order
+static float getButterworthQ(int order, int section)
+{
+	auto angle = juce::MathConstants<double>::pi * (2 * section + 1) / (2.0 * order);
+	return (float)(1.0 / (2.0 * std::sin(angle)));
+}
+
+//==============================================================================
+void SvfEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+	sampleRate = spec.sampleRate;
+	numChannels = (int)spec.numChannels;
+
+	state.assign((size_t)(ChainSettings::numBands * maxSections * numChannels * 2), 0.f);
+
+	for (auto& band : bands)
+	{
+		band.freq.reset(sampleRate, smoothingTimeSeconds);
+		band.gain.reset(sampleRate, smoothingTimeSeconds);
+	}
+
+	reset();
+}
+
+void SvfEngine::setSampleRate(double newSampleRate)
+{
+	if (newSampleRate <= 0.0 || newSampleRate == sampleRate)
+		return;
+
+	sampleRate = newSampleRate;
+
+	for (auto& band : bands)
+	{
+		band.freq.reset(sampleRate, smoothingTimeSeconds);
+		band.gain.reset(sampleRate, smoothingTimeSeconds);
+		updateBandCoefficients(band, band.freq.getCurrentValue(), getGain(band));
+	}
+}
+
+void SvfEngine::reset()
+{
+	std::fill(state.begin(), state.end(), 0.f);
+
+	//jump straight to the targets so switching engines doesn't start with a sweep
+	for (auto& band : bands)
+	{
+		band.freq.setCurrentAndTargetValue(band.freq.getTargetValue());
+		band.gain.setCurrentAndTargetValue(band.gain.getTargetValue());
+		updateBandCoefficients(band, band.freq.getCurrentValue(), getGain(band));
+	}
+}
+
+void SvfEngine::setTargets(const ChainSettings& chainSettings)
+{
+	for (int i = 0; i < ChainSettings::numBands; ++i)
+	{
+		const auto& bandSettings = chainSettings.bandSettings[i];
+		auto& band = bands[i];
+
+		//SmoothedValue<Multiplicative> can't start from 0
+		auto freq = juce::jmax(bandSettings.band_freq, 1.f);
+
+		if (!hasTargets)
+		{
+			band.freq.setCurrentAndTargetValue(freq);
+			band.gain.setCurrentAndTargetValue(bandSettings.band_gain);
+		}
+		else
+		{
+			band.freq.setTargetValue(freq);
+			band.gain.setTargetValue(bandSettings.band_gain);
+		}
+
+		//until the dynamics engine reports in, a band turning dynamic sits at its static gain
+		if (bandSettings.isDynamic() && !band.isDynamic)
+			band.dynamicGainDb = bandSettings.band_gain;
+
+		auto wasDynamic = band.isDynamic;
+		band.isDynamic = bandSettings.isDynamic();
+		band.channels = chainSettings.getBandChannels(i);
+
+		//type and slope can't be morphed, they switch at the next sample
+		if (!hasTargets || band.type != bandSettings.band_type || band.slope != bandSettings.band_slope || wasDynamic != band.isDynamic)
+		{
+			band.type = bandSettings.band_type;
+			band.slope = bandSettings.band_slope;
+			band.numSections = band.type == BandType::Peak ? 1 : band.slope + 1;
+			updateBandCoefficients(band, band.freq.getCurrentValue(), getGain(band));
+		}
+	}
+
+	hasTargets = true;
+}
+
+void SvfEngine::setDynamicGain(int bandIndex, float gainDb)
+{
+	auto& band = bands[bandIndex];
+
+	if (!band.isDynamic)
+		return;
+
+	band.dynamicGainDb = gainDb;
+	updateBandCoefficients(band, band.freq.getCurrentValue(), gainDb);
+}
+
+void SvfEngine::updateBandCoefficients(Band& band, float freq, float gainDb)
+{
+	switch (band.type)
+	{
+	case BandType::Peak:
+		band.sections[0] = makeSvfPeak(freq, gainDb, 1.f, sampleRate);
+		break;
+	case BandType::LowPass:
+		for (int i = 0; i < band.numSections; ++i)
+			band.sections[i] = makeSvfLowPass(freq, getButterworthQ(2 * band.numSections, i), sampleRate);
+		break;
+	case BandType::HighPass:
+		for (int i = 0; i < band.numSections; ++i)
+			band.sections[i] = makeSvfHighPass(freq, getButterworthQ(2 * band.numSections, i), sampleRate);
+		break;
+	}
+}
+
+float* SvfEngine::getState(int band, int section, int channel)
+{
+	return state.data() + ((band * maxSections + section) * numChannels + channel) * 2;
+}
+
+void SvfEngine::process(const juce::dsp::AudioBlock<float>& block)
+{
+	const auto channelsToProcess = juce::jmin((int)block.getNumChannels(), numChannels);
+	const auto numSamples = (int)block.getNumSamples();
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		for (int b = 0; b < ChainSettings::numBands; ++b)
+		{
+			auto& band = bands[b];
+
+			if (band.freq.isSmoothing() || band.gain.isSmoothing())
+			{
+				auto freq = band.freq.getNextValue();
+				auto gain = band.gain.getNextValue();
+				updateBandCoefficients(band, freq, band.isDynamic ? band.dynamicGainDb : gain);
+			}
+
+			for (int s = 0; s < band.numSections; ++s)
+			{
+				const auto& c = band.sections[s];
+				auto* sectionState = getState(b, s, 0);
+
+				for (int ch = 0; ch < channelsToProcess; ++ch, sectionState += 2)
+				{
+					if (!isRoutedTo(band.channels, ch))
+						continue;
+
+					auto* sample = block.getChannelPointer((size_t)ch) + i;
+
+					auto& ic1eq = sectionState[0];
+					auto& ic2eq = sectionState[1];
+
+					auto v0 = *sample;
+					auto v3 = v0 - ic2eq;
+					auto v1 = c.a1 * ic1eq + c.a2 * v3;
+					auto v2 = ic2eq + c.a2 * ic1eq + c.a3 * v3;
+
+					ic1eq = 2.f * v1 - ic1eq;
+					ic2eq = 2.f * v2 - ic2eq;
+
+					*sample = c.m0 * v0 + c.m1 * v1 + c.m2 * v2;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    SvfEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChainSettings.h"
+
+//Topology preserving transform state variable filter (trapezoidal integrators).
+//Output is m0 * input + m1 * bandpass + m2 * lowpass.
+struct SvfCoefficients
+{
+	float a1 = 1.f, a2 = 0.f, a3 = 0.f;
+	float m0 = 1.f, m1 = 0.f, m2 = 0.f;
+};
+
+SvfCoefficients makeSvfPeak(float freq, float gainDb, float q, double sampleRate);
+SvfCoefficients makeSvfLowPass(float freq, float q, double sampleRate);
+SvfCoefficients makeSvfHighPass(float freq, float q, double sampleRate);
+
+//Alternative to the biquad engine for heavy automation: band frequency and gain are
+//smoothed per sample and the cheap closed form SVF coefficients follow them, so sweeps
+//never zipper and never need a Butterworth redesign at audio rate
+class SvfEngine
+{
+public:
+	static constexpr int maxSections = 4;
+
+	void prepare(const juce::dsp::ProcessSpec& spec);
+	void reset();
+
+	//Audio thread safe, used when the oversampling factor changes
+	void setSampleRate(double newSampleRate);
+
+	//Audio thread safe, sets the smoothing targets
+	void setTargets(const ChainSettings& chainSettings);
+
+	//Audio thread: replaces the smoothed gain of a dynamic peak band until the next setTargets
+	void setDynamicGain(int band, float gainDb);
+
+	void process(const juce::dsp::AudioBlock<float>& block);
+
+private:
+	struct Band
+	{
+		juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> freq;
+		juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> gain;
+		BandType type{ BandType::Peak };
+		Slope slope{ Slope::Slope_12 };
+		int numSections = 1;
+		std::array<SvfCoefficients, maxSections> sections;
+		//the detector already smooths a dynamic band's gain, so it bypasses the gain smoother
+		bool isDynamic = false;
+		float dynamicGainDb = 0.f;
+		BandChannels channels{ BandChannels::BothChannels };
+	};
+
+	void updateBandCoefficients(Band& band, float freq, float gainDb);
+	static float getGain(Band& band) { return band.isDynamic ? band.dynamicGainDb : band.gain.getCurrentValue(); }
+	float* getState(int band, int section, int channel);
+
+	std::array<Band, ChainSettings::numBands> bands;
+
+	//two integrator states per band, section and channel
+	std::vector<float> state;
+	int numChannels = 0;
+	double sampleRate = 44100.0;
+	bool hasTargets = false;
+
+	static constexpr double smoothingTimeSeconds = 0.05;
+};
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+//Single producer / single consumer handoff of whole objects.
+//The writer fills getWriteBuffer() and publishes it, the reader picks up the newest
+//published object with acquire(). Neither side ever blocks or allocates.
+template<typename T>
+class TripleBuffer
+{
+public:
+	//Writer side
+	T& getWriteBuffer() { return buffers[backIndex]; }
+
+	void publish()
+	{
+		auto previous = middle.exchange(backIndex | newDataFlag, std::memory_order_acq_rel);
+		backIndex = previous & indexMask;
+	}
+
+	//Reader side: returns the newest object if one was published since the last call, nullptr otherwise
+	const T* acquire()
+	{
+		if ((middle.load(std::memory_order_relaxed) & newDataFlag) == 0)
+			return nullptr;
+
+		auto previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+		frontIndex = previous & indexMask;
+		return &buffers[frontIndex];
+	}
+
+	//Reader side: the object returned by the last successful acquire()
+	const T& getReadBuffer() const { return buffers[frontIndex]; }
+
+private:
+	static constexpr int indexMask = 3;
+	static constexpr int newDataFlag = 4;
+
+	std::array<T, 3> buffers{};
+	std::atomic<int> middle{ 1 };
+	int backIndex = 0;
+	int frontIndex = 2;
+};